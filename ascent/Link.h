@@ -34,7 +34,7 @@ namespace asc
       Link() {}
 
       template <typename... Types>
-      Link(const size_t sim, Types&&... args) : module(new Unqualified<T>(sim, std::forward<Types>(args)...)) {}
+      Link(const size_t sim, Types&&... args) : module(create(sim, std::forward<Types>(args)...)) {}
 
       Link(const Link<T>& link)
       {
@@ -86,6 +86,15 @@ namespace asc
       }
 
    private:
+      template <typename... Types>
+      static std::shared_ptr<Unqualified<T>> create(const size_t sim, Types&&... args)
+      {
+         const std::shared_ptr<Arena>& arena = Module::getSimulator(sim).arena;
+         if (arena) // the module and its shared_ptr control block in a single allocation, whose allocator keeps the arena alive
+            return std::allocate_shared<Unqualified<T>>(ArenaAllocator<Unqualified<T>>(arena), sim, std::forward<Types>(args)...);
+         return std::shared_ptr<Unqualified<T>>(new Unqualified<T>(sim, std::forward<Types>(args)...));
+      }
+
       T* access()
       {
          if (!module)
@@ -94,33 +103,8 @@ namespace asc
             return nullptr;
          }
 
-         const Phase& phase = module->simulator.phase;
-
-         if (phase != Phase::setup)
-         {
-            // For all phases except "setup", init() must have been called prior to access.
-            // Calling the method callInit() ensures that initialization has been properly handled. Once a module has been initialized this method will simply do nothing.
-            // This call is essential for simulations that add modules during the simulation loop.
-            module->callInit();
-
-            switch (phase)
-            {
-            case Phase::update:
-               module->callUpdate();
-               break;
-            case Phase::postcalc:
-               module->callPostCalc();
-               break;
-            case Phase::check:
-               module->callCheck();
-               break;
-            case Phase::reset:
-               module->callReset();
-               break;
-            default:
-               break;
-            }
-         }
+         if (module->access_epoch != module->simulator.epoch) // otherwise init() and the current phase call have already been handled during this phase
+            module->callAccess();
 
          return module.get();
       }
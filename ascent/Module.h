@@ -15,6 +15,9 @@
 #pragma once
 
 #include "core/ModuleMacros.h" // Grouped into separate header to keep Module.h cleaner
+#include "ascent/core/TrackRows.h"
+#include "ascent/io/JsonWriter.h"
+#include "ascent/io/SharedTelemetry.h"
 
 /** Forward Declarations for Nodal Editor */
 namespace dynode { class Editor; class Plotter; class Menu; }
@@ -101,6 +104,27 @@ namespace asc
       /** Runs this module's associated simulator at currently set dt_base and t_end values. */
       bool run() { return simulator.run(); }
 
+      /** Save this module's simulator to a binary checkpoint file: the time base and time history, integrator states (with stage and multistep history), every defined variable with its tracked history, and module wiring (phases, tracking, runBefore ordering, and defined links).
+      * Checkpoints are saved between runs or from report(). Internal state that isn't a defined variable is saved by overriding serialize().
+      * @param file_name  The checkpoint file.
+      */
+      bool checkpoint(const std::string& file_name);
+
+      /** Restore a checkpoint file into this module's simulator, before it runs. The simulator's modules must be constructed again in the same order, with the same integrator.
+      * Running the simulator then continues from the checkpoint, as another run() call would have.
+      * @param file_name  The checkpoint file.
+      */
+      bool restore(const std::string& file_name);
+
+      /** Fork this module's simulator into independent child simulators, to explore what-if branches from a common prefix without simulating the prefix again.
+      * Each child is built by build(sim), which must set the same integrator and construct (and keep alive) the same modules, in the same order, in simulator sim. The child is then restored from this simulator, as from a checkpoint().
+      * Recorded histories are shared with the children copy on write, so a fork only copies live state. Forks are made between runs or from report().
+      * @param n  The number of children.
+      * @param build  Builds a child's modules in simulator sim.
+      * @return The simulator numbers of the children, which may be run in parallel with runParallel().
+      */
+      std::vector<size_t> fork(const size_t n, const std::function<void(size_t sim)>& build);
+
       /** The simulator's current time. */
       const double& t;
 
@@ -123,7 +147,7 @@ namespace asc
       }
 
       /** Retrieve a vector of the time history, with the time at each full step recorded. */
-      const std::vector<double>& timeHistory() const { return simulator.t_hist; };
+      const Chunked<double>& timeHistory() const { return simulator.t_hist; };
 
       /** Obtain time history of a tracked variable.
       * @param id  The string identification of the variable.
@@ -132,6 +156,12 @@ namespace asc
       template <typename T>
       std::deque<T> history(const std::string& id) { return vars.history<T>(id); }
 
+      /** Obtain a handle to a defined variable. The handle can be stored and used for repeated access without string lookups.
+      * @param id  The string identification of the variable.
+      */
+      template <typename T>
+      Var<T> handle(const std::string& id) { return vars.handle<T>(id); }
+
       /** True if at the first update of the current simulation run.
       * True only for the first pass on update() for the current run() call.
       */
@@ -244,6 +274,12 @@ namespace asc
       */
       void track(const std::string& var_name);
 
+      /** Specify a variable to be tracked at a reduced rate.
+      * @param var_name  Associated variable name.
+      * @param rate  The recording rate, e.g. Rate::sample(0.1) records at multiples of 0.1 seconds and Rate::every(10) records every tenth full step.
+      */
+      void track(const std::string& var_name, const Rate& rate);
+
       /** Specify a variable to be tracked.
       * @param module_name  Name of module to track the variable.
       * @param var_name  Associated variable name.
@@ -256,6 +292,19 @@ namespace asc
       */
       void track(Module& module, const std::string& var_name);
 
+      /** Specify a variable to be tracked at a reduced rate.
+      * @param module  An uncontained Module.
+      * @param var_name  Associated variable name.
+      * @param rate  The recording rate.
+      */
+      void track(Module& module, const std::string& var_name, const Rate& rate);
+
+      /** Set the recording rate of every variable this module tracks, including those tracked later, and of its streamed rows (see streamFiles()).
+      * Variables written to the same file should share a rate, so that their rows line up.
+      * @param rate  The recording rate.
+      */
+      void trackRate(const Rate& rate);
+
       /** Specify a variable in a Link contained Module to be tracked.
       * @param link  Link contained Module.
       * @param var_name  Associated variable name.
@@ -271,7 +320,7 @@ namespace asc
          else
          {
             tracking.push_back(std::make_pair(link.module->module_id, var_name));
-            link.module->steps(var_name);
+            trackSteps(*link.module, var_name);
          }
       }
 
@@ -281,14 +330,58 @@ namespace asc
       /** Create a string in csv format from tracked data. */
       std::string csvTrack();
 
-      /** Create a string in JSON format from tracked data. */
-      std::string jsonTrack();
+      /** Create a string in JSON format from tracked data, written directly from the tracked histories.
+      * @param layout  JsonLayout::rows (an array of rows, headed by the column names, the default) or JsonLayout::columns (an object with an array per column).
+      */
+      std::string jsonTrack(const JsonLayout layout = JsonLayout::rows);
+
+      /** Write tracked data in JSON format to a stream (e.g. a file), see jsonTrack(layout). */
+      void jsonTrack(std::ostream& stream, const JsonLayout layout = JsonLayout::rows);
+
+      /** Write tracked data in the binary columnar format, see ascent/io/BinaryTrack.h. */
+      void binaryTrack(std::ostream& stream);
 
       void streamCSV(std::shared_ptr<std::stringstream>& ss);
 
+      /** Stream this Module's tracked data to its output file on a background thread while the simulation runs, rather than holding it all in memory until the end of the run.
+      * Variables must be tracked before the first time step is recorded. Streamed files are text (.csv or .txt).
+      * @param retention  The number of steps of history to keep in memory for tracked variables (i.e. for history access), zero keeps none.
+      */
+      void streamFiles(const size_t retention = 0);
+
+      /** Serve JsonAPI requests from other processes over a Unix domain socket while this Module's simulator runs (see ascent/io/TelemetryServer.h), not available on Windows.
+      * Requests are applied between full steps. Modules are accessed by the names given with name<T>(name).
+      * @param socket_path  The file path of the socket, an existing file at this path is replaced.
+      */
+      void serveTelemetry(const std::string& socket_path);
+
+      /** Publish the current values of this Module's tracked variables to POSIX shared memory every full step, for other processes to read with SharedTelemetry::Reader (see ascent/io/SharedTelemetry.h).
+      * Only numeric and fixed size Eigen types can be shared (as doubles). Variables must be tracked before the first time step is recorded. Not available on Windows.
+      * @param name  Name of the shared memory object, e.g. "/sim_telemetry".
+      * @param capacity  The number of most recent frames (full steps) kept for readers.
+      */
+      void shareTelemetry(const std::string& name, const size_t capacity = 1024);
+
+      /** Include a variable in the simulator's Snapshot (see ascent/core/Snapshot.h), so that other threads can read a step coherent copy of it while the simulation runs.
+      * JsonAPI reads the current values of snapshot variables from the snapshot. Add variables before other threads start reading.
+      */
+      void snapshot(const std::string& var_name);
+
+      /** Losslessly compress the recorded histories of the simulator (tracked variables and time), which are decompressed as they're accessed.
+      * Smooth signals typically shrink several fold, regularly spaced times by far more. Only types made up of doubles are compressed.
+      * @param compress  Whether or not to compress histories, recorded data is only compressed as each chunk of 4096 values fills.
+      */
+      void compressHistory(const bool compress = true) { simulator.compressHistory(compress); }
+
       /** Change output file type to .txt instead of .csv */
       void txtFiles() { file_type = ".txt"; }
 
+      /** Change output file type to binary columnar .ascb files instead of .csv (see ascent/io/BinaryTrack.h) */
+      void binaryFiles() { file_type = ".ascb"; }
+
+      /** Change output file type to .json files instead of .csv, with an array of values per tracked variable (JsonLayout::columns) */
+      void jsonFiles() { file_type = ".json"; }
+
       /** Generate a manipulator module whose memory is owned by this module as long as the manipulator isn't also stored elsewhere (if Link<T> isn't saved).
       * Manipulators should usually only mess with parameters from this module.
       * Manipulators are ordered via the runBefore method, so they always run before the module they are manipulating.
@@ -399,20 +492,26 @@ namespace asc
 
       void addPhases();
 
+      /** Save or restore internal state that isn't a defined variable, for checkpoints (see checkpoint()).
+      * archive(a, b, ...) saves the values, or restores them when archive.loading(). Numbers, strings, std containers, and Eigen types are supported.
+      */
+      virtual void serialize(Archive& archive) {}
+
       /** Enables a variable in this Module to be tracked and/or externally accessed and set.
       * @param id  The string identification used to access the variable.
       * @param x  Variable to be tracked via a pointer. Hence the variable's memory should be owned by this class.
       * @param infinite  Set infinite to true in order to record history of the variable indefinitely.
+      * @return A handle to the variable, which converts to T& and provides access without a string lookup.
       */
       template <typename T>
-      T& define(const std::string& id, T &x, bool infinite = false)
+      Var<T> define(const std::string& id, T &x, bool infinite = false)
       {
          if (!simulator.trackers.count(module_id))
             simulator.trackers[module_id] = this;
 
-         vars.init(id, x, 0);
-         vars.steps(id, infinite);
-         return x;
+         Var<T> var = vars.init(id, x, 0);
+         var.param().setInfinite(infinite);
+         return var;
       }
 
       /** Set the number of time steps to keep track of for a tracked variable.
@@ -492,9 +591,28 @@ namespace asc
       void callCheck();
       void callReport();
       void callReset();
+      void callAccess(); // handles init() and the current phase call for Link access
 
       void tracker() { vars.update(); }
 
+      Rate track_rate; // recording rate for the variables tracked by this module
+      Decimator stream_decimator; // decides which rows are streamed when only the time is tracked
+      std::vector<Decimator> stream_decimators; // decide which rows each tracked variable is streamed in, at the variable's own rate
+      std::vector<char> stream_due; // whether each tracked variable is due in the current row
+
+      bool streaming = false;
+      size_t stream_retention = 0;
+      StreamWriter::Stream* stream = nullptr; // do not delete, owned by the simulator's StreamWriter
+      std::vector<ParameterBase*> stream_columns;
+      void streamRow(); // hands the current values of the tracked variables to the StreamWriter
+
+      std::string shared_name;
+      size_t shared_capacity = 0;
+      std::unique_ptr<SharedTelemetry::Writer> shared_telemetry;
+      std::vector<const void*> shared_values; // current values of the tracked variables, resolved with the first frame
+      void shareRow(); // publishes a frame of the tracked variables' current values
+      void trackSteps(Module& module, const std::string& var_name); // sets the history length for a newly tracked variable
+
       std::function<void()> chaiscript_event;
 
       mutable std::string module_name = "";
@@ -512,11 +630,9 @@ namespace asc
       bool reset_called = false;
 
       bool init_run = false;
-      bool update_run = false;
-      bool postcalc_run = false;
-      bool check_run = false;
-      bool report_run = false;
-      bool reset_run = false;
+      size_t run_epoch = 0; // simulator epoch in which this module's current phase call completed
+      size_t access_epoch = 0; // simulator epoch in which Link access last completed, after which access needs no further handling
+      bool ran() const { return run_epoch == simulator.epoch; } // whether the current phase call has completed
 
       std::map<size_t, std::weak_ptr<Module>> run_first; // other modules that must be run before this module is updated
 
@@ -524,6 +640,7 @@ namespace asc
 
       std::vector<State*> states; // Must be owned by this module. (i.e. addIntegrator should only be called on this module's variables)
       void propagateStates();
+      void changeIntegrator(); // Rebuilds this module's states with the simulator's current integrator.
 
       // manipulators contains modules whose lifetime is to be maintained by this module, and whose modules shouldn't be accessed by other modules.
       std::vector<std::shared_ptr<Module>> manipulators; // Uses std::shared_ptr rather than std::unique_ptr because of std::weak_ptr use for ordering (runBefore()).
@@ -540,20 +657,25 @@ namespace asc
 
       Module& getModule(const size_t id);
 
+      void serializeModule(Archive& archive, const std::vector<Module*>& order, const std::map<size_t, size_t>& positions); // see Simulator::serialize
+
+      void jsonTrack(JsonWriter& writer, const JsonLayout layout);
+
       // For file streaming or stringstream.
       template <typename T>
       void streamTrack(T& stream)
       {
          if (tracking.size() > 0)
          {
-            size_t id = tracking.front().first;
-            std::string var_name = tracking.front().second;
+            std::vector<ParameterBase*> columns; // resolved once, rather than looking up every variable for every row
+            for (auto& p : tracking)
+               columns.push_back(getModule(p.first).vars.findTrackable(p.second, "streamTrack"));
 
-            size_t length;
-            if (id == module_id)
-               length = vars.length(var_name);
-            else
-               length = getModule(id).vars.length(var_name);
+            for (ParameterBase* column : columns)
+            {
+               if (!column)
+                  return;
+            }
 
             if (print_time)
                stream << "t" << ",";
@@ -570,21 +692,28 @@ namespace asc
 
             stream << '\n';
 
-            for (size_t i = 0; i < length; ++i)
+            std::string row; // reused for every row, so rows are formatted without allocating
+            TrackRows rows(columns); // variables tracked at different rates share rows by time, with blank cells where a variable has no sample
+            while (rows.advance())
             {
+               row.clear();
+
                if (print_time)
-                  stream << simulator.t_hist[i] << ",";
+               {
+                  Format::append(row, simulator.t_hist[rows.t_index]);
+                  row += ',';
+               }
 
-               n = tracking.size();
                for (size_t j = 0; j < n; ++j)
                {
-                  auto& p = tracking[j];
-                  stream << getModule(p.first).vars.print(p.second, i);
+                  if (rows.has(j))
+                     columns[j]->format(row, rows.sample(j));
                   if (j < n - 1) // not the last parameter
-                     stream << ",";
+                     row += ',';
                }
 
-               stream << '\n';
+               row += '\n';
+               stream.write(row.data(), row.size());
             }
          }
       }
@@ -600,18 +729,28 @@ namespace asc
    };
 
    /** Set the integrator for the simulator whose number is input.
+   * The integrator may be changed while states exist, even during a simulation run. Outside of a run the change is immediate, otherwise it is applied at the end of the current full step.
+   * States are rebuilt from their current values and derivatives. Multistep methods are seeded again from the current states, so tracked histories are unaffected.
    * @param sim  The simulator number.
    */
    template <typename T>
    inline void integrator(size_t sim)
    {
       Simulator& s = Module::getSimulator(sim);
-      if (s.propagate.size() > 0)
-         s.setError("States have already been set for integration. The integrator cannot be changed.");
-      else
-         s.integrator = std::make_unique<T>(s.stepper);
+      s.integrator_change = std::make_unique<T>(s.stepper);
+
+      if (s.phase == Phase::setup)
+         s.changeIntegrator(); // change now
    }
 
+   /** Allocate the modules created through Link<T>, their integrated states and their variables from an arena (see Arena), rather than individually from the heap.
+   * Memory is laid out in construction order and released all at once, when the last module of the simulator has been destroyed. Intended for very large models.
+   * Must be called before any module of the simulator is created.
+   * @param sim  The simulator number.
+   * @param block_size  The number of bytes reserved at a time.
+   */
+   void arena(const size_t sim, const size_t block_size = 1 << 20);
+
    /** Set the relative error integration tolerance for the entire simulator associated with this module.
    * @param sim  The simulator number.
    * @param tolerance  The integration tolerance. If negative, it will turn off step resizing for all states in this module's simulator.
@@ -622,4 +761,11 @@ namespace asc
    * @param file_name  The name of the file to be generated. Automatically appended with .asc
    */
    inline void generateInputFile(const std::string& file_name);
+
+   /** Run simulators on separate threads (e.g. the children of Module::fork()), until each reaches t_end or stops.
+   * Modules must not be created or deleted while the simulators run, because the module tables are shared by all simulators.
+   * @param sims  The simulator numbers.
+   * @return Returns true if every simulator ran without an error.
+   */
+   bool runParallel(const std::vector<size_t>& sims, const double dt_base, const double t_end);
 }
\ No newline at end of file
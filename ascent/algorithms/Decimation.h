@@ -0,0 +1,170 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+// Decimation selects a subset of a time history's samples for display, so that long histories can be plotted with a few thousand points.
+// Each method returns the indices of the kept samples in increasing order. x(i) and y(i) are functions of a sample index returning doubles,
+// so histories are read in place rather than copied.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace asc
+{
+   namespace Decimation
+   {
+      /** Every kth sample of [begin, end), keeping at most max_points. Works for any type of value. */
+      inline std::vector<size_t> stride(const size_t begin, const size_t end, const size_t max_points)
+      {
+         std::vector<size_t> indices;
+         const size_t n = end > begin ? end - begin : 0;
+         if (n == 0 || max_points == 0)
+            return indices;
+
+         const size_t k = (n + max_points - 1) / max_points;
+         for (size_t i = begin; i < end; i += k)
+            indices.push_back(i);
+         return indices;
+      }
+
+      /** The minimum and maximum sample of each of max_points / 2 equal buckets of [begin, end), which preserves peaks (e.g. for envelopes of oscillating signals). */
+      template <typename Fy>
+      inline std::vector<size_t> minMax(const Fy& y, const size_t begin, const size_t end, const size_t max_points)
+      {
+         std::vector<size_t> indices;
+         const size_t n = end > begin ? end - begin : 0;
+         if (n <= max_points || max_points < 2)
+         {
+            if (max_points > 0 && n <= max_points)
+            {
+               for (size_t i = begin; i < end; ++i)
+                  indices.push_back(i);
+            }
+            else if (max_points == 1)
+               indices.push_back(begin);
+            return indices;
+         }
+
+         const size_t buckets = max_points / 2;
+         for (size_t b = 0; b < buckets; ++b)
+         {
+            const size_t first = begin + b * n / buckets;
+            const size_t last = begin + (b + 1) * n / buckets;
+
+            size_t i_min = first, i_max = first;
+            double y_min = y(first), y_max = y_min;
+            for (size_t i = first + 1; i < last; ++i)
+            {
+               const double yi = y(i);
+               if (yi < y_min)
+               {
+                  y_min = yi;
+                  i_min = i;
+               }
+               else if (yi > y_max)
+               {
+                  y_max = yi;
+                  i_max = i;
+               }
+            }
+
+            if (i_min == i_max)
+               indices.push_back(i_min);
+            else
+            {
+               indices.push_back(std::min(i_min, i_max));
+               indices.push_back(std::max(i_min, i_max));
+            }
+         }
+         return indices;
+      }
+
+      /** Largest-Triangle-Three-Buckets (Steinarsson 2013), which keeps the visual shape of a line plot.
+      * The first and last samples are kept, and from each bucket in between the sample forming the largest triangle with the previously kept sample and the average of the next bucket.
+      */
+      template <typename Fx, typename Fy>
+      inline std::vector<size_t> lttb(const Fx& x, const Fy& y, const size_t begin, const size_t end, const size_t max_points)
+      {
+         const size_t n = end > begin ? end - begin : 0;
+         if (n <= max_points || max_points < 3)
+         {
+            if (n > max_points) // too few points for buckets
+               return stride(begin, end, max_points);
+
+            std::vector<size_t> indices;
+            for (size_t i = begin; i < end; ++i)
+               indices.push_back(i);
+            return indices;
+         }
+
+         std::vector<size_t> indices;
+         indices.reserve(max_points);
+
+         const double every = static_cast<double>(n - 2) / (max_points - 2); // bucket size, excluding the first and last samples
+         size_t a = begin; // the previously kept sample
+         indices.push_back(a);
+
+         for (size_t b = 0; b < max_points - 2; ++b)
+         {
+            // The average of the next bucket (the last sample for the last bucket).
+            size_t next_first = begin + static_cast<size_t>(std::floor((b + 1) * every)) + 1;
+            size_t next_last = std::min(begin + static_cast<size_t>(std::floor((b + 2) * every)) + 1, end);
+            if (next_first >= next_last)
+            {
+               next_first = end - 1;
+               next_last = end;
+            }
+
+            double x_avg = 0.0, y_avg = 0.0;
+            for (size_t i = next_first; i < next_last; ++i)
+            {
+               x_avg += x(i);
+               y_avg += y(i);
+            }
+            const double count = static_cast<double>(next_last - next_first);
+            x_avg /= count;
+            y_avg /= count;
+
+            // The sample of this bucket forming the largest triangle.
+            const size_t first = begin + static_cast<size_t>(std::floor(b * every)) + 1;
+            const size_t last = begin + static_cast<size_t>(std::floor((b + 1) * every)) + 1;
+
+            const double xa = x(a);
+            const double ya = y(a);
+
+            double max_area = -1.0;
+            size_t kept = first;
+            for (size_t i = first; i < last; ++i)
+            {
+               const double area = std::abs((xa - x_avg) * (y(i) - ya) - (xa - x(i)) * (y_avg - ya)); // twice the triangle's area
+               if (area > max_area)
+               {
+                  max_area = area;
+                  kept = i;
+               }
+            }
+
+            indices.push_back(kept);
+            a = kept;
+         }
+
+         indices.push_back(end - 1);
+         return indices;
+      }
+   }
+}
\ No newline at end of file
@@ -14,6 +14,10 @@
 
 #pragma once
 
+#include <Eigen/Dense>
+
+#include <array>
+#include <cmath>
 #include <deque>
 
 // Algorithms are designed to handle std::vector and std::deque (for shifting transient problems), should also handle std::array.
@@ -69,6 +73,14 @@ namespace asc
          }
       }
 
+      // Weights of the three-point (quadratic) derivative at xest, for unequally spaced points x0, x1, x2.
+      inline void threePointWeights(const double x0, const double x1, const double x2, const double xest, double& w0, double& w1, double& w2)
+      {
+         w0 = (2.0 * xest - x1 - x2) / ((x0 - x1)*(x0 - x2));
+         w1 = (2.0 * xest - x0 - x2) / ((x1 - x0)*(x1 - x2));
+         w2 = (2.0 * xest - x0 - x1) / ((x2 - x0)*(x2 - x1));
+      }
+
       // Supports std::vector and std::deque
       // x is the independant variable, y is dependent. Returns derivative for unequally spaced points. xest is the x value at which to evaluate the derivative.
       // x and y vectors don't need to be the same length if they have three elements or more each
@@ -83,17 +95,10 @@ namespace asc
             return (y.back() - y.front()) / (x.back() - x.front());
          else
          {
-            double x2 = x[nx - 1];
-            double x1 = x[nx - 2];
-            double x0 = x[nx - 3];
-
-            double y2 = y[ny - 1];
-            double y1 = y[ny - 2];
-            double y0 = y[ny - 3];
+            double w0, w1, w2;
+            threePointWeights(x[nx - 3], x[nx - 2], x[nx - 1], xest, w0, w1, w2);
 
-            double dydx = y0*(2.0 * xest - x1 - x2) / ((x0 - x1)*(x0 - x2)) + y1*(2.0 * xest - x0 - x2) / ((x1 - x0)*(x1 - x2)) + y2*(2.0 * xest - x0 - x1) / ((x2 - x0)*(x2 - x1));
-
-            return dydx;
+            return w0*y[ny - 3] + w1*y[ny - 2] + w2*y[ny - 1];
          }
       }
 
@@ -109,6 +114,7 @@ namespace asc
 
       // E is intended to be an Eigen::Vector, such as Eigen::Vector3d, supports n dimensional Eigen C++ vectors
       // T1 and T2 can be std::vector or std::deque
+      // The three-point weights are computed once and applied to every dimension in a single expression, so fixed size vectors never allocate.
       template <typename E, typename T1, typename T2>
       inline E vecDerivative(const T1 &t, const T2 &v)
       {
@@ -118,20 +124,95 @@ namespace asc
          else if (n == 2)
             return (v[1] - v[0]) / (t[1] - t[0]);
 
-         std::vector<std::vector<double>> dimensional_history; // each vector is for a dimension, such as x, y, z, . . . (can have more dimensions than 3), saving three time steps of history
-         size_t dimensions = v[0].rows();
-         dimensional_history.resize(dimensions);
-         for (size_t i = 0; i < dimensions; ++i)
+         double w0, w1, w2;
+         threePointWeights(t[n - 3], t[n - 2], t[n - 1], t[n - 1], w0, w1, w2);
+
+         return w0*v[n - 3] + w1*v[n - 2] + w2*v[n - 1];
+      }
+
+      // A derivative stencil over the latest points of a history, evaluated at the latest point. T is the value type, double or a fixed size Eigen vector.
+      // A polynomial of the given degree is fit to the points by least squares and differentiated order times. With degree = points - 1 the polynomial
+      // interpolates the points (a higher order finite difference), with a lower degree the stencil is a Savitzky-Golay filter that smooths noise.
+      // Spacing may be unequal. The weights are only recomputed when the spacing of the points changes, so with a constant time step each evaluation
+      // is a single weighted sum of the values, without heap allocation.
+      // Until a history has enough points, the three-point derivative is used instead.
+      template <typename T, size_t points, size_t degree = points - 1, size_t order = 1>
+      class Stencil
+      {
+         static_assert(degree < points, "Derivative::Stencil needs more points than the polynomial degree");
+         static_assert(order >= 1 && order <= degree, "Derivative::Stencil order must be between one and the polynomial degree");
+
+      private:
+         std::array<double, points> offsets; // x - xest of the points the weights were computed for
+         std::array<double, points> weights;
+         bool cached = false;
+
+         template <typename T1, typename T2>
+         static double fallback(const double*, const T1& x, const T2& y) { return derivative(x, y); }
+
+         template <typename U, typename T1, typename T2>
+         static U fallback(const U*, const T1& x, const T2& y) { return vecDerivative<U>(x, y); }
+
+         void compute(const double h)
          {
-            for (size_t j = 3; j > 0; --j) // iterate over last three states, from oldest to newest
-               dimensional_history[i].push_back(v[n - j][i]); // this will push back the ith states (i.e. if i = 0, x dimension) from the last three Eigen::Vector states
+            typedef Eigen::Matrix<double, points, degree + 1> Vandermonde;
+
+            Vandermonde vandermonde;
+            for (size_t i = 0; i < points; ++i)
+            {
+               const double s = offsets[i] / h; // scaled, so that the fit is well conditioned for any time step
+               double power = 1.0;
+               for (size_t j = 0; j <= degree; ++j)
+               {
+                  vandermonde(i, j) = power;
+                  power *= s;
+               }
+            }
+
+            const Eigen::Matrix<double, degree + 1, points> fit = vandermonde.colPivHouseholderQr().solve(Eigen::Matrix<double, points, points>::Identity()); // least squares polynomial coefficients from the values
+
+            double scale = 1.0; // order! / h^order
+            for (size_t k = 1; k <= order; ++k)
+               scale *= static_cast<double>(k) / h;
+
+            for (size_t i = 0; i < points; ++i)
+               weights[i] = scale * fit(order, i);
          }
 
-         E deriv;
-         for (size_t i = 0; i < dimensions; ++i)
-            deriv[i] = derivative(t, dimensional_history[i]); // t can contain more than 3 steps
+      public:
+         double tolerance = 1e-9; // relative change in spacing (to the mean spacing) below which the cached weights are reused
 
-         return deriv;
-      }
+         /** The derivative of y with respect to x at the latest point. x and y may differ in length, their latest points are aligned. */
+         template <typename T1, typename T2>
+         T operator()(const T1& x, const T2& y)
+         {
+            const size_t nx = x.size();
+            const size_t ny = y.size();
+            if (nx < points || ny < points)
+               return fallback(static_cast<const T*>(nullptr), x, y);
+
+            const double xest = x[nx - 1];
+            const double h = (xest - x[nx - points]) / static_cast<double>(points - 1); // mean spacing
+
+            bool changed = !cached;
+            for (size_t i = 0; i < points && !changed; ++i)
+               changed = std::abs(x[nx - points + i] - xest - offsets[i]) > tolerance * std::abs(h);
+
+            if (changed)
+            {
+               for (size_t i = 0; i < points; ++i)
+                  offsets[i] = x[nx - points + i] - xest;
+               compute(h);
+               cached = true;
+            }
+
+            T result = weights[0] * y[ny - points];
+            for (size_t i = 1; i < points; ++i)
+               result += weights[i] * y[ny - points + i];
+            return result;
+         }
+
+         const std::array<double, points>& stencil() const { return weights; } // the weights of the last evaluation, oldest point first
+      };
    };
 }
\ No newline at end of file
@@ -14,7 +14,9 @@
 
 #pragma once
 
-#include <iostream>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
 
 namespace asc
 {
@@ -26,10 +28,7 @@ namespace asc
       {
          // Uses the composite trapezoidal rule to calculate the integral for unequally spaced data.
          if (x.size() != y.size())
-         {
-            std::cout << "ERROR: Vectors to be integrated with trapUnequal are of differing size." << '\n';
-            return 0.0;
-         }
+            throw std::runtime_error("Vectors to be integrated with trapUnequal are of differing size.");
 
          if (x.size() < 2)
             return 0.0;
@@ -43,5 +42,117 @@ namespace asc
 
          return I;
       }
+
+      inline double trapezoid(const double x0, const double y0, const double x1, const double y1) { return (x1 - x0) * (y1 + y0) / 2.0; }
+
+      // Integral over [x0, x1] of the parabola through three unequally spaced points (5/12, 8/12, -1/12 of h for equal spacing).
+      inline double parabolicFirst(const double x0, const double y0, const double x1, const double y1, const double x2, const double y2)
+      {
+         const double h0 = x1 - x0;
+         const double h1 = x2 - x1;
+         const double H = h0 + h1;
+         return (h0 / 2.0 - h0*h0 / (6.0*H))*y0 + (h0*(3.0*H - 2.0*h0) / (6.0*h1))*y1 - (h0*h0*h0 / (6.0*H*h1))*y2;
+      }
+
+      // Integral over [x1, x2] of the parabola through three unequally spaced points.
+      inline double parabolicLast(const double x0, const double y0, const double x1, const double y1, const double x2, const double y2)
+      {
+         return parabolicFirst(-x2, y2, -x1, y1, -x0, y0); // mirrored
+      }
+
+      enum class Rule
+      {
+         trapezoid, // second order
+         parabolic // Simpson's rule on unequal spacing: each interval integrates the parabola through it and the following point (the newest interval uses the previous point)
+      };
+
+      // Running integral of a history (x increasing), updated in O(1) as values are appended and the oldest values are removed, rather than summing the whole history.
+      // The intervals are summed with Neumaier's compensated summation, so rounding doesn't accumulate over long runs. Removing intervals still drifts, so owners reset() the sum when drifted().
+      class Running
+      {
+      private:
+         Rule method;
+         double sum = 0.0;
+         double compensation = 0.0;
+         size_t removed = 0; // values removed since the sum was computed with reset()
+
+         void add(const double term)
+         {
+            const double total = sum + term;
+            if (std::abs(sum) >= std::abs(term))
+               compensation += (sum - total) + term;
+            else
+               compensation += (term - total) + sum;
+            sum = total;
+         }
+
+         template <typename Tx, typename Ty>
+         double interval(const Tx& x, const Ty& y, const size_t i) const // the summed contribution of the interval [i, i + 1], which needs x[i + 2] for the parabolic rule
+         {
+            if (method == Rule::parabolic)
+               return parabolicFirst(x[i], y[i], x[i + 1], y[i + 1], x[i + 2], y[i + 2]);
+            return trapezoid(x[i], y[i], x[i + 1], y[i + 1]);
+         }
+
+         size_t lag() const { return (method == Rule::parabolic) ? 2 : 1; } // the number of newest values whose intervals aren't yet summed
+
+      public:
+         Running(const Rule rule = Rule::trapezoid) : method(rule) {}
+
+         Rule rule() const { return method; }
+
+         /** Update the sum after a value has been appended to x and y. */
+         template <typename Tx, typename Ty>
+         void push(const Tx& x, const Ty& y)
+         {
+            const size_t n = x.size();
+            if (n > lag())
+               add(interval(x, y, n - lag() - 1));
+         }
+
+         /** Update the sum before the oldest value of x and y is removed. */
+         template <typename Tx, typename Ty>
+         void pop(const Tx& x, const Ty& y)
+         {
+            const size_t n = x.size();
+            if (n > lag())
+               add(-interval(x, y, 0));
+            if (n <= lag() + 1) // no summed intervals remain
+               clear();
+            ++removed;
+         }
+
+         /** Recompute the sum from the whole history, O(n). */
+         template <typename Tx, typename Ty>
+         void reset(const Tx& x, const Ty& y)
+         {
+            clear();
+            const size_t n = x.size();
+            for (size_t i = 0; i + lag() < n; ++i)
+               add(interval(x, y, i));
+         }
+
+         void clear()
+         {
+            sum = 0.0;
+            compensation = 0.0;
+            removed = 0;
+         }
+
+         bool drifted(const size_t size) const { return removed > size; } // whether every value of a history of the given size has been removed since reset() (see RunningStatistics::drifted)
+
+         /** The integral over the whole history. */
+         template <typename Tx, typename Ty>
+         double value(const Tx& x, const Ty& y) const
+         {
+            const size_t n = x.size();
+            double I = sum + compensation;
+            if (method == Rule::parabolic && n >= 3)
+               I += parabolicLast(x[n - 3], y[n - 3], x[n - 2], y[n - 2], x[n - 1], y[n - 1]);
+            else if (method == Rule::parabolic && n == 2)
+               I += trapezoid(x[0], y[0], x[1], y[1]);
+            return I;
+         }
+      };
    }
 };
\ No newline at end of file
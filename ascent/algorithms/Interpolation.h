@@ -14,23 +14,32 @@
 
 #pragma once
 
+#include "Derivative.h"
+
 #include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace asc
 {
    namespace Interpolation
    {
-      template <typename T>
-      inline double linear(const double x_target, const std::vector<T>& x, const std::vector<T>& y) // linear interpolation for doubles
+      // Interpolation supports std::vector, std::deque, and RingBuffer (any container with random access iterators).
+
+      template <typename Tx, typename Ty>
+      inline double linear(const double x_target, const Tx& x, const Ty& y) // linear interpolation for doubles
       {
          size_t high = std::lower_bound(x.begin(), x.end(), x_target) - x.begin(); // std::lower_bound(...) returns iterator to first value in x that is not less than x_target
 
          if (high == 0)
             return y.front();
+         else if (high == x.size())
+            return y[high - 1];
 
          size_t low = high - 1;
 
@@ -43,8 +52,8 @@ namespace asc
          return y0 + (y1 - y0)*(x_target - x0) / (x1 - x0); // linear interpolation (returns y_estimate)
       }
 
-      template <typename T>
-      inline double linearCheck(const double x_target, const std::vector<T>& x, const std::vector<T>& y) // includes a check for out of bounds
+      template <typename Tx, typename Ty>
+      inline double linearCheck(const double x_target, const Tx& x, const Ty& y) // includes a check for out of bounds
       {
          if (x_target < x.front())
             throw std::runtime_error("ERROR: The access value (x_target) is less than the lowest x value.\n");
@@ -57,9 +66,9 @@ namespace asc
       }
 
       // closestNeighbor is for values such as integers that shouldn't be interpolated, but whose value closest to the desired (target) x value should be returned.
-      // Supports std::vectors or std::deques
-      template <typename T>
-      inline auto closestNeighbor(const double x_target, const std::vector<double>& x, const T& y) -> typename std::decay<decltype(y.front())>::type
+      // Supports std::vectors, std::deques, or RingBuffers
+      template <typename Tx, typename T>
+      inline auto closestNeighbor(const double x_target, const Tx& x, const T& y) -> typename std::decay<decltype(y.front())>::type
       {
          size_t high = std::upper_bound(x.begin(), x.end(), x_target) - x.begin(); // get indice to first value greater than x_target
 
@@ -77,5 +86,166 @@ namespace asc
                return y[low];
          }
       }
+
+      // Cursor interpolates a history (x increasing) at a sequence of target values, remembering the bracket of the last target.
+      // When targets move monotonically (e.g. playback or delay lookups), the bracket is advanced by an exponential search from the last one,
+      // so each target costs amortized O(1) instead of a binary search of the whole history. Any container with operator [] is supported
+      // (std::vector, std::deque, RingBuffer, Chunked, HistoryPyramid views). The history may grow or drop old values between targets, the bracket is revalidated.
+      // Targets outside of the history hold the first or last value.
+      template <typename Tx, typename Ty>
+      class Cursor
+      {
+      public:
+         typedef typename std::decay<decltype(std::declval<const Ty&>()[0])>::type value_type;
+
+      private:
+         const Tx& x;
+         const Ty& y;
+         size_t i = 0; // low index of the last bracket
+
+         size_t size() const { return std::min(x.size(), y.size()); }
+
+         template <typename Td>
+         value_type hermite(const double x_target, const size_t low, const Td& m0, const Td& m1) const // cubic Hermite on the bracket [low, low + 1], m0 and m1 are the slopes at its ends
+         {
+            const double h = x[low + 1] - x[low];
+            const double s = (x_target - x[low]) / h;
+            const double s2 = s*s;
+            const double r = 1.0 - s;
+
+            return (1.0 + 2.0*s)*r*r*y[low] + (s*r*r*h)*m0 + s2*(3.0 - 2.0*s)*y[low + 1] - (s2*r*h)*m1;
+         }
+
+         value_type slope(const size_t k) const // finite difference slope of y at x[k], three-point for interior points
+         {
+            const size_t n = size();
+            if (k == 0 || n == 2)
+               return (y[1] - y[0]) / (x[1] - x[0]);
+            else if (k == n - 1)
+               return (y[k] - y[k - 1]) / (x[k] - x[k - 1]);
+
+            double w0, w1, w2;
+            Derivative::threePointWeights(x[k - 1], x[k], x[k + 1], x[k], w0, w1, w2);
+            return w0*y[k - 1] + w1*y[k] + w2*y[k + 1];
+         }
+
+      public:
+         Cursor(const Tx& x, const Ty& y) : x(x), y(y) {}
+
+         /** The index i of the bracket x[i] <= x_target < x[i + 1], clamped to the first and last brackets. */
+         size_t locate(const double x_target)
+         {
+            const size_t n = size();
+            if (n < 2)
+               return 0;
+
+            const size_t last = n - 2; // the last bracket
+            if (i > last)
+               i = last;
+
+            if (x_target >= x[i + 1]) // search forward
+            {
+               size_t lo = i + 1; // x[lo] <= x_target
+               if (lo > last)
+                  return i = last;
+
+               size_t step = 1;
+               while (lo + step <= last && x[lo + step] <= x_target)
+               {
+                  lo += step;
+                  step *= 2;
+               }
+               const size_t hi = std::min(lo + step, last + 1);
+               i = (std::upper_bound(x.begin() + lo + 1, x.begin() + hi, x_target) - x.begin()) - 1;
+            }
+            else if (x_target < x[i]) // search backward
+            {
+               size_t hi = i; // x[hi] > x_target
+               size_t step = 1;
+               while (hi >= step && x[hi - step] > x_target)
+               {
+                  hi -= step;
+                  step *= 2;
+               }
+               const size_t lo = (hi >= step) ? hi - step : 0;
+               const size_t high = std::upper_bound(x.begin() + lo, x.begin() + hi, x_target) - x.begin();
+               i = (high > 0) ? high - 1 : 0;
+            }
+            return i;
+         }
+
+         value_type linear(const double x_target)
+         {
+            const size_t n = size();
+            if (n < 2 || x_target <= x[0])
+               return y[0];
+            else if (x_target >= x[n - 1])
+               return y[n - 1];
+
+            const size_t low = locate(x_target);
+            return y[low] + (y[low + 1] - y[low])*((x_target - x[low]) / (x[low + 1] - x[low]));
+         }
+
+         value_type closestNeighbor(const double x_target)
+         {
+            const size_t n = size();
+            if (n < 2)
+               return y[0];
+
+            const size_t low = locate(x_target);
+            if (std::abs(x_target - x[low + 1]) < std::abs(x_target - x[low]))
+               return y[low + 1];
+            return y[low];
+         }
+
+         /** Cubic Hermite interpolation, with slopes estimated from the neighboring values (three-point derivatives). */
+         value_type hermite(const double x_target)
+         {
+            const size_t n = size();
+            if (n < 2 || x_target <= x[0])
+               return y[0];
+            else if (x_target >= x[n - 1])
+               return y[n - 1];
+
+            const size_t low = locate(x_target);
+            return hermite(x_target, low, slope(low), slope(low + 1));
+         }
+
+         /** Cubic Hermite interpolation with stored derivatives yd (dy/dx at every x), e.g. the derivative history of an integrated state. */
+         template <typename Td>
+         value_type hermite(const double x_target, const Td& yd)
+         {
+            const size_t n = std::min(size(), static_cast<size_t>(yd.size()));
+            if (n < 2 || x_target <= x[0])
+               return y[0];
+            else if (x_target >= x[n - 1])
+               return y[n - 1];
+
+            const size_t low = std::min(locate(x_target), n - 2);
+            return hermite(x_target, low, yd[low], yd[low + 1]);
+         }
+      };
+
+      template <typename Tx, typename Ty>
+      inline Cursor<Tx, Ty> cursor(const Tx& x, const Ty& y) { return Cursor<Tx, Ty>(x, y); }
+
+      // Batched interpolation of sorted targets, written to out (an output iterator). Each target costs amortized O(1) (see Cursor).
+      template <typename Tt, typename Tx, typename Ty, typename Out>
+      inline Out linear(const Tt& x_targets, const Tx& x, const Ty& y, Out out)
+      {
+         Cursor<Tx, Ty> c(x, y);
+         for (const double x_target : x_targets)
+            *out++ = c.linear(x_target);
+         return out;
+      }
+
+      template <typename Tt, typename Tx, typename Ty, typename Out>
+      inline Out hermite(const Tt& x_targets, const Tx& x, const Ty& y, Out out)
+      {
+         Cursor<Tx, Ty> c(x, y);
+         for (const double x_target : x_targets)
+            *out++ = c.hermite(x_target);
+         return out;
+      }
    }
 }
\ No newline at end of file
@@ -0,0 +1,199 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// RecursiveLeastSquares is a streaming alternative to Fit2D and Extrapolation, fitting y = f(x) (e.g. y = A + B*x + C*x*x) to samples as they arrive.
+// The normal equations of the fit are updated in O(k^2) per sample, for k basis functions, rather than solving an SVD of every sample on every call.
+// Old samples are forgotten either by removing them from a sliding window (the oldest sample first), or exponentially, by weighting samples by forgetting^age.
+// The basis is evaluated relative to an origin near the samples, like the x shift of Fit2D, so that the fit stays well conditioned as x grows.
+// Once every sample has been replaced, the owner recomputes the fit from its window with reset(), which moves the origin up (amortized O(k^2) per sample).
+// When the basis returns a fixed size Eigen vector (such as Eigen::Vector3d) nothing is allocated.
+
+#include <Eigen/Dense>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+namespace asc
+{
+   template <typename Basis>
+   class RecursiveLeastSquares
+   {
+   public:
+      typedef typename std::decay<decltype(std::declval<Basis>()(0.0))>::type Vector; // basis function values (an Eigen vector)
+      typedef Eigen::Matrix<double, Vector::RowsAtCompileTime, Vector::RowsAtCompileTime> Matrix;
+
+   private:
+      Basis basis;
+      double lambda; // forgetting factor, 1.0 for no exponential forgetting
+      size_t memory; // number of samples until a sample's weight is forgotten (below machine epsilon)
+
+      Matrix G; // sum of weighted basis outer products (A^T*A)
+      Vector g; // sum of weighted basis values times y (A^T*b)
+      double yy = 0.0; // sum of weighted y squared (b^T*b)
+      Vector c; // fit coefficients, valid when solved
+      bool solved = false;
+
+      double x0 = 0.0; // origin of the basis
+      size_t n = 0; // samples in the fit
+      size_t added = 0; // samples added since the fit was computed with reset()
+
+      void initialize(const double x)
+      {
+         x0 = x;
+         const Vector phi = basis(0.0);
+         G.setZero(phi.size(), phi.size());
+         g.setZero(phi.size());
+         c.setZero(phi.size());
+         yy = 0.0;
+      }
+
+      void accumulate(const double x, const double y, const double weight)
+      {
+         const Vector phi = basis(x - x0);
+         G.noalias() += weight * phi * phi.transpose();
+         g += (weight * y) * phi;
+         yy += weight * y * y;
+         solved = false;
+      }
+
+      static size_t memoryOf(const double lambda)
+      {
+         if (lambda < 1.0 && lambda > 0.0)
+            return static_cast<size_t>(std::log(std::numeric_limits<double>::epsilon()) / std::log(lambda)) + 1;
+         return std::numeric_limits<size_t>::max();
+      }
+
+      void decay()
+      {
+         if (lambda < 1.0)
+         {
+            G *= lambda;
+            g *= lambda;
+            yy *= lambda;
+         }
+      }
+
+   public:
+      RecursiveLeastSquares(const Basis& basis = Basis(), const double forgetting = 1.0) : basis(basis), lambda(forgetting), memory(memoryOf(forgetting)) {}
+
+      /** Add the newest sample. */
+      void add(const double x, const double y)
+      {
+         if (n == 0)
+            initialize(x);
+         else
+            decay();
+
+         accumulate(x, y, 1.0);
+         ++n;
+         ++added;
+      }
+
+      /** Remove the oldest sample of a sliding window, which must be the oldest sample added. */
+      void remove(const double x, const double y)
+      {
+         if (n <= 1)
+         {
+            clear();
+            return;
+         }
+
+         accumulate(x, y, -std::pow(lambda, static_cast<double>(n - 1))); // the oldest sample has been decayed once per newer sample
+         --n;
+      }
+
+      /** Recompute the fit from the samples of a window (oldest first), with the origin at the oldest sample. Samples whose weight has been forgotten are skipped. */
+      template <typename Tx, typename Ty>
+      void reset(const Tx& xs, const Ty& ys)
+      {
+         clear();
+
+         const size_t size = std::min(xs.size(), ys.size());
+         const size_t begin = (size > memory) ? size - memory : 0;
+
+         if (begin == size)
+            return;
+
+         initialize(xs[begin]);
+         for (size_t i = begin; i < size; ++i)
+            accumulate(xs[i], ys[i], std::pow(lambda, static_cast<double>(size - 1 - i)));
+         n = size - begin;
+      }
+
+      void clear()
+      {
+         n = 0;
+         added = 0;
+         solved = false;
+      }
+
+      /** Change the forgetting factor, the fit must then be recomputed with reset(). */
+      void setForgetting(const double forgetting)
+      {
+         lambda = forgetting;
+         memory = memoryOf(forgetting);
+         added = std::numeric_limits<size_t>::max();
+      }
+
+      double forgetting() const { return lambda; }
+
+      /** Whether the fit should be recomputed with reset(), because every sample has been replaced since it was (or the forgetting factor changed). */
+      bool drifted() const { return added > std::max<size_t>(std::min(n, memory), 2 * static_cast<size_t>(g.size())); }
+
+      size_t size() const { return n; }
+      double origin() const { return x0; } // the coefficients are for the basis evaluated at x - origin()
+
+      /** The fit coefficients, solved when samples have changed (O(k^3) for the k x k normal equations, which are equilibrated for conditioning, k is small). */
+      const Vector& coefficients()
+      {
+         if (!solved && n > 0)
+         {
+            const Vector scale = G.diagonal().cwiseMax(std::numeric_limits<double>::min()).cwiseSqrt().cwiseInverse();
+            const Matrix scaled = scale.asDiagonal() * G * scale.asDiagonal();
+            if (n >= static_cast<size_t>(g.size()))
+               c = scale.cwiseProduct(scaled.ldlt().solve(scale.cwiseProduct(g)));
+            else // fewer samples than basis functions, the minimum norm solution (as with an SVD)
+               c = scale.cwiseProduct(scaled.completeOrthogonalDecomposition().solve(scale.cwiseProduct(g)));
+            solved = true;
+         }
+         return c;
+      }
+
+      /** The fit evaluated at x, relative_error is the norm of the fit residuals relative to the norm of the (weighted) samples, as with Extrapolation::extrapolate. */
+      double estimate(const double x, double& relative_error)
+      {
+         if (n < 2) // if there are less than two values then there is no use extrapolating
+         {
+            relative_error = 1.0;
+            return 0.0;
+         }
+
+         const Vector& constants = coefficients();
+
+         if (yy < 1.0e-16) // handle case where all y values are zero
+         {
+            relative_error = 0.0;
+            return 0.0;
+         }
+         relative_error = std::sqrt(std::max(yy - constants.dot(g), 0.0) / yy); // at the solution, |A*c - b|^2 = b^T*b - c^T*A^T*b
+
+         return constants.dot(basis(x - x0));
+      }
+   };
+}
\ No newline at end of file
@@ -0,0 +1,169 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// RunningStatistics keeps the statistics of a sliding window up to date as values enter and leave it, so that every query is O(1).
+// The mean and variance are updated with Welford's algorithm (which can also remove a value), and the minimum and maximum are the fronts of monotonic queues (amortized O(1) per value).
+// Values may be doubles or Eigen vectors, whose statistics are coefficient-wise.
+
+#include "ascent/core/RingBuffer.h"
+
+#include <Eigen/Dense>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace asc
+{
+   template <typename T>
+   class RunningStatistics
+   {
+   private:
+      size_t n = 0;
+      T mu{}; // mean
+      T m2{}; // sum of squared differences from the mean
+      uint64_t first = 0; // sequence number of the oldest value in the window
+      uint64_t next = 0; // sequence number of the next value pushed
+      size_t removed = 0; // values removed since the statistics were last computed from scratch
+
+      // Candidates for the minimum and maximum of each coefficient (sequence number and value), increasing and decreasing from the front respectively.
+      std::vector<RingBuffer<std::pair<uint64_t, double>>> lows, highs;
+
+      static size_t dims(const double) { return 1; }
+      template <typename U> static size_t dims(const U& x) { return x.size(); }
+
+      static double coeff(const double x, const size_t) { return x; }
+      template <typename U> static double coeff(const U& x, const size_t i) { return x(i); }
+
+      static void setCoeff(double& x, const size_t, const double value) { x = value; }
+      template <typename U> static void setCoeff(U& x, const size_t i, const double value) { x(i) = value; }
+
+      static double zero(const double) { return 0.0; }
+      template <typename U> static U zero(const U& like) { return U::Zero(like.rows(), like.cols()); }
+
+      static double product(const double a, const double b) { return a * b; }
+      template <typename U> static T product(const U& a, const U& b) { return a.cwiseProduct(b); }
+
+      static double nonNegative(const double x) { return std::max(x, 0.0); } // removals can leave rounding errors slightly below zero
+      template <typename U> static T nonNegative(const U& x) { return x.cwiseMax(0.0); }
+
+      static double sqrt(const double x) { return std::sqrt(x); }
+      template <typename U> static T sqrt(const U& x) { return x.cwiseSqrt(); }
+
+      T extreme(const std::vector<RingBuffer<std::pair<uint64_t, double>>>& queues) const
+      {
+         T result = mu;
+         if (n > 0)
+         {
+            for (size_t d = 0; d < queues.size(); ++d)
+               setCoeff(result, d, queues[d].front().second);
+         }
+         return result;
+      }
+
+   public:
+      /** Add the newest value to the window. */
+      void push(const T& value)
+      {
+         if (n == 0)
+         {
+            mu = zero(value);
+            m2 = zero(value);
+            lows.resize(dims(value));
+            highs.resize(dims(value));
+         }
+
+         ++n;
+         const T delta = value - mu;
+         mu += delta / static_cast<double>(n);
+         const T after = value - mu;
+         m2 += product(delta, after);
+
+         for (size_t d = 0; d < lows.size(); ++d)
+         {
+            const double x = coeff(value, d);
+
+            while (!lows[d].empty() && lows[d].back().second >= x)
+               lows[d].pop_back();
+            lows[d].push_back(std::make_pair(next, x));
+
+            while (!highs[d].empty() && highs[d].back().second <= x)
+               highs[d].pop_back();
+            highs[d].push_back(std::make_pair(next, x));
+         }
+         ++next;
+      }
+
+      /** Remove the oldest value from the window, value must be the oldest value pushed. */
+      void pop(const T& value)
+      {
+         if (n <= 1)
+         {
+            clear();
+            return;
+         }
+
+         const T after = value - mu;
+         --n;
+         mu -= after / static_cast<double>(n);
+         const T delta = value - mu;
+         m2 -= product(delta, after);
+
+         ++removed;
+         ++first;
+         for (size_t d = 0; d < lows.size(); ++d)
+         {
+            if (lows[d].front().first < first)
+               lows[d].pop_front();
+            if (highs[d].front().first < first)
+               highs[d].pop_front();
+         }
+      }
+
+      /** Recompute the statistics of a window from its values, O(n), used when values are removed from the middle of the window. */
+      template <typename Container>
+      void reset(const Container& values)
+      {
+         clear();
+         for (const T& value : values)
+            push(value);
+      }
+
+      void clear()
+      {
+         n = 0;
+         removed = 0;
+         first = next = 0;
+         for (auto& queue : lows)
+            queue.clear();
+         for (auto& queue : highs)
+            queue.clear();
+      }
+
+      /** Whether every value of the window has been replaced by removals since the statistics were last computed with reset(). Removals accumulate rounding error (badly so after large transients), so owners reset() the window when drifted, which is amortized O(1). */
+      bool drifted() const { return removed > n; }
+
+      // The statistics of an empty window are undefined.
+      size_t size() const { return n; }
+      const T& mean() const { return mu; }
+      T variance() const { return nonNegative(m2 / static_cast<double>(std::max<size_t>(n, 1))); } // population variance, as Statistics::stdDeviation
+      T stdDeviation() const { return sqrt(variance()); }
+      T min() const { return extreme(lows); }
+      T max() const { return extreme(highs); }
+   };
+}
\ No newline at end of file
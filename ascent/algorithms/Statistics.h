@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include "ascent/core/RingBuffer.h"
+
 #include <Eigen/Dense>
 
 #include <algorithm>
@@ -38,9 +40,34 @@ namespace asc
       template <typename T>
       inline double stdDeviation(const T &x)
       {
-         T diff(x.size());
-         std::transform(x.begin(), x.end(), diff.begin(), std::bind2nd(std::minus<double>(), mean(x)));
-         double sq_sum = std::inner_product(diff.begin(), diff.end(), diff.begin(), 0.0);
+         const double mu = mean(x);
+         double sq_sum = 0.0;
+         for (const double value : x)
+            sq_sum += (value - mu) * (value - mu);
+         return std::sqrt(sq_sum / x.size());
+      }
+
+      // RingBuffer histories are reduced span by span, so that the loops run over contiguous memory without copying.
+
+      template <typename T>
+      inline double mean(const RingBuffer<T> &x)
+      {
+         auto spans = x.spans();
+         double sum = std::accumulate(spans.first.begin(), spans.first.end(), 0.0);
+         sum = std::accumulate(spans.second.begin(), spans.second.end(), sum);
+         return sum / x.size();
+      }
+
+      template <typename T>
+      inline double stdDeviation(const RingBuffer<T> &x)
+      {
+         const double mu = mean(x);
+         auto spans = x.spans();
+         double sq_sum = 0.0;
+         for (const T& value : spans.first)
+            sq_sum += (value - mu) * (value - mu);
+         for (const T& value : spans.second)
+            sq_sum += (value - mu) * (value - mu);
          return std::sqrt(sq_sum / x.size());
       }
    }
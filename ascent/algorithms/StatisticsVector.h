@@ -20,68 +20,55 @@ namespace asc
 {
    namespace StatisticsVector
    {
-      // Supports std::vectors or std::deques of Eigen::Vectors
-      template <typename T>
-      auto mean(const T &v) -> typename std::decay<decltype(v.front())>::type
-      {
-         return mean(v, v.size());
-      }
-
-      // Supports std::vectors or std::deques of Eigen::Vectors
+      // Supports std::vectors, std::deques, or RingBuffers of Eigen::Vectors
+      // The statistics of the last steps values are coefficient-wise, computed in place without copying the values.
       template <typename T>
       auto mean(const T &v, const size_t steps) -> typename std::decay<decltype(v.front())>::type
       {
          size_t n = v.size();
          if (n > 1)
          {
-            Eigen::MatrixXd data(steps, v.front().size());
-            for (size_t i = 1; i <= steps; ++i)
-               data.row(steps - i) = v[n - i];
+            typename std::decay<decltype(v.front())>::type sum = v[n - steps];
+            for (size_t i = n - steps + 1; i < n; ++i)
+               sum += v[i];
 
-            return Eigen::VectorXd(data.colwise().mean());
+            return sum / static_cast<double>(steps);
          }
          else
             return v.front();
       }
 
-      // Supports std::vectors or std::deques of Eigen::Vectors
-      template <typename T>
-      auto stdDeviation(const T &v) -> typename std::decay<decltype(v.front())>::type
-      {
-         return stdDeviation(v, v.size());
-      }
-
-      // Supports std::vectors or std::deques of Eigen::Vectors
+      // Supports std::vectors, std::deques, or RingBuffers of Eigen::Vectors
       template <typename T>
       auto stdDeviation(const T &v, const size_t steps) -> typename std::decay<decltype(v.front())>::type
       {
          size_t n = v.size();
          if (n > 1)
          {
-            Eigen::MatrixXd data(steps, v.front().size());
-            for (size_t i = 1; i <= steps; ++i)
-               data.row(steps - i) = v[n - i];
-
-            std::vector<std::vector<double>> columns;
-            for (int c = 0; c < data.cols(); ++c)
-            {
-               columns.push_back(std::vector<double>());
-               for (int r = 0; r < data.rows(); ++r)
-                  columns[c].push_back(data(r, c));
-            }
+            const auto mu = mean(v, steps);
 
-            std::vector<double> sigmas;
-            for (auto& column : columns)
-               sigmas.push_back(Statistics::stdDeviation(column));
+            typename std::decay<decltype(v.front())>::type sq_sum = (v[n - steps] - mu).cwiseAbs2();
+            for (size_t i = n - steps + 1; i < n; ++i)
+               sq_sum += (v[i] - mu).cwiseAbs2();
 
-            Eigen::VectorXd result(sigmas.size());
-            for (size_t i = 0; i < sigmas.size(); ++i)
-               result(i) = sigmas[i];
-
-            return result;
+            return (sq_sum / static_cast<double>(steps)).cwiseSqrt();
          }
          else
             return v.front();
       }
+
+      // Supports std::vectors, std::deques, or RingBuffers of Eigen::Vectors
+      template <typename T>
+      auto mean(const T &v) -> typename std::decay<decltype(v.front())>::type
+      {
+         return mean(v, v.size());
+      }
+
+      // Supports std::vectors, std::deques, or RingBuffers of Eigen::Vectors
+      template <typename T>
+      auto stdDeviation(const T &v) -> typename std::decay<decltype(v.front())>::type
+      {
+         return stdDeviation(v, v.size());
+      }
    }
 }
\ No newline at end of file
@@ -0,0 +1,114 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// Arena is an opt-in, per-simulator allocator for building very large models (see asc::arena).
+// Allocations are carved sequentially out of large blocks, so modules, their integrated states and their variables are laid out in construction order,
+// and nothing is released until the arena is destroyed, all at once. The arena is shared by everything allocated from it and outlives the simulator
+// until the last of its modules has been destroyed. Like the simulator, an arena isn't thread safe.
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace asc
+{
+   class Arena
+   {
+   private:
+      std::vector<std::unique_ptr<char[]>> blocks;
+      char* head = nullptr; // the next free byte of the current block
+      size_t remaining = 0; // free bytes in the current block
+      size_t used = 0; // bytes allocated, including alignment padding
+      size_t reserved = 0; // bytes of all blocks
+
+   public:
+      explicit Arena(const size_t block_size = 1 << 20) : block_size(block_size) {}
+
+      Arena(const Arena&) = delete;
+      Arena& operator = (const Arena&) = delete;
+
+      const size_t block_size;
+
+      void* allocate(const size_t bytes, const size_t alignment = alignof(std::max_align_t));
+
+      size_t size() const { return used; } // bytes allocated
+      size_t capacity() const { return reserved; } // bytes reserved in blocks
+
+      // While a Scope exists, ArenaAllocated objects created on this thread are allocated from its arena (a nullptr arena allocates from the heap).
+      class Scope
+      {
+      private:
+         Arena* previous;
+
+      public:
+         Scope(Arena* arena);
+         ~Scope();
+
+         Scope(const Scope&) = delete;
+         Scope& operator = (const Scope&) = delete;
+      };
+
+      static Arena* current(); // the arena of the innermost Scope on this thread, nullptr if none
+   };
+
+   // Base for classes whose objects are allocated from the current Arena (see Arena::Scope) when there is one, and from the heap otherwise.
+   // Deleting an object allocated from an arena only runs its destructor, its memory is released with the arena.
+   class ArenaAllocated
+   {
+   public:
+      static void* operator new(const size_t bytes);
+      static void operator delete(void* p) noexcept;
+   };
+
+   // Standard allocator over a shared Arena, each copy keeps the arena alive. Without an arena it allocates from the heap.
+   template <typename T>
+   class ArenaAllocator
+   {
+   public:
+      typedef T value_type;
+      typedef std::true_type propagate_on_container_move_assignment;
+      typedef std::true_type propagate_on_container_swap;
+
+      ArenaAllocator() {}
+      ArenaAllocator(const std::shared_ptr<Arena>& arena) : arena(arena) {}
+
+      template <typename U>
+      ArenaAllocator(const ArenaAllocator<U>& rhs) : arena(rhs.arena) {}
+
+      std::shared_ptr<Arena> arena;
+
+      T* allocate(const size_t n)
+      {
+         if (arena)
+            return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+         return static_cast<T*>(::operator new(n * sizeof(T)));
+      }
+
+      void deallocate(T* p, const size_t)
+      {
+         if (!arena)
+            ::operator delete(p);
+      }
+   };
+
+   template <typename T, typename U>
+   bool operator == (const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) { return lhs.arena == rhs.arena; }
+
+   template <typename T, typename U>
+   bool operator != (const ArenaAllocator<T>& lhs, const ArenaAllocator<U>& rhs) { return lhs.arena != rhs.arena; }
+}
\ No newline at end of file
@@ -0,0 +1,234 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+// Chunked is append only storage for long histories. Values are held in fixed size chunks that are never moved, so appending never copies previous values.
+// Full chunks can be compressed losslessly (see Gorilla.h), types made of doubles with XOR compression and times with delta of delta compression.
+// Compressed chunks are decompressed into a single chunk cache when accessed, so sequential access (iterators, exporters) remains amortized O(1), but random access costs a chunk decode.
+// Accessing compressed chunks modifies the cache, so a Chunked object must not be read from multiple threads at once.
+// Filled chunks are never modified, so copies share them (copy on write), only the chunk being filled is copied. Copies can be used by different threads.
+
+#include "ascent/core/Gorilla.h"
+#include "ascent/core/RingBuffer.h"
+#include "ascent/io/BinaryTrack.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace asc
+{
+   enum class Codec
+   {
+      none,
+      xor_values, // for smooth signals
+      delta_of_delta // for regularly spaced times, only applied to scalars
+   };
+
+   template <typename T>
+   class Chunked
+   {
+   public:
+      static const size_t chunk_size = 4096;
+
+   private:
+      struct Chunk
+      {
+         std::shared_ptr<T> raw; // uncompressed values (an array), null once compressed
+         std::shared_ptr<const std::vector<uint64_t>> bits; // compressed values
+         Codec codec = Codec::none;
+      };
+
+      std::vector<Chunk> chunks;
+      size_t n = 0; // number of values
+      Codec codec = Codec::none; // applied to chunks as they're filled
+      std::shared_ptr<T> spare; // buffer released by the last compressed chunk, reused for the next chunk
+
+      mutable std::unique_ptr<T[]> cache; // the most recently decompressed chunk
+      mutable size_t cached = SIZE_MAX; // index of the chunk held in cache
+
+      static size_t lanes() { return BinaryTrack::Type<T>::layout().elements(); }
+      static bool compressible() { return BinaryTrack::supported<T>() && BinaryTrack::Type<T>::layout().scalar == BinaryTrack::Scalar::float64; }
+
+      void seal(Chunk& chunk) // compress a full chunk
+      {
+         if (codec == Codec::none || !compressible() || !chunk.raw)
+            return;
+
+         const double* values = reinterpret_cast<const double*>(chunk.raw.get()); // supported types are contiguous doubles
+         auto bits = std::make_shared<std::vector<uint64_t>>();
+         if (codec == Codec::delta_of_delta && lanes() == 1)
+         {
+            Gorilla::encodeDeltaOfDelta(values, chunk_size, *bits);
+            chunk.codec = Codec::delta_of_delta;
+         }
+         else
+         {
+            Gorilla::encodeXor(values, chunk_size, lanes(), *bits);
+            chunk.codec = Codec::xor_values;
+         }
+         bits->shrink_to_fit();
+         chunk.bits = bits;
+
+         if (chunk.raw.use_count() == 1) // a buffer shared with a copy can't be reused
+            spare = std::move(chunk.raw);
+         else
+            chunk.raw.reset();
+      }
+
+      const T* data(const size_t c) const
+      {
+         const Chunk& chunk = chunks[c];
+         if (chunk.raw)
+            return chunk.raw.get();
+
+         if (cached != c)
+         {
+            if (!cache)
+               cache.reset(new T[chunk_size]);
+
+            double* values = reinterpret_cast<double*>(cache.get());
+            if (chunk.codec == Codec::delta_of_delta)
+               Gorilla::decodeDeltaOfDelta(chunk.bits->data(), values, chunk_size);
+            else
+               Gorilla::decodeXor(chunk.bits->data(), values, chunk_size, lanes());
+            cached = c;
+         }
+         return cache.get();
+      }
+
+      Chunk newChunk()
+      {
+         Chunk chunk;
+         chunk.raw = spare ? std::move(spare) : std::shared_ptr<T>(new T[chunk_size], std::default_delete<T[]>());
+         return chunk;
+      }
+
+   public:
+      typedef T value_type;
+      typedef IndexIterator<const Chunked, const T> const_iterator;
+      typedef const_iterator iterator; // stored values can't be modified
+
+      Chunked() {}
+      Chunked(const Chunked& rhs) { *this = rhs; }
+      Chunked(Chunked&& rhs) = default;
+
+      /** Copies share the filled chunks, only the chunk being filled is copied. */
+      Chunked& operator = (const Chunked& rhs)
+      {
+         if (this != &rhs)
+         {
+            chunks.clear();
+            const size_t count = rhs.chunkCount();
+            for (size_t c = 0; c < count; ++c)
+            {
+               const size_t filled = std::min(chunk_size, rhs.n - c * chunk_size);
+               if (filled == chunk_size)
+                  chunks.push_back(rhs.chunks[c]);
+               else
+               {
+                  chunks.push_back(newChunk());
+                  std::copy(rhs.chunks[c].raw.get(), rhs.chunks[c].raw.get() + filled, chunks.back().raw.get());
+               }
+            }
+
+            n = rhs.n;
+            codec = rhs.codec;
+            cached = SIZE_MAX;
+         }
+         return *this;
+      }
+
+      Chunked& operator = (Chunked&& rhs) = default;
+
+      size_t size() const { return n; }
+      bool empty() const { return n == 0; }
+
+      void push_back(const T& value)
+      {
+         const size_t c = n / chunk_size;
+         if (c == chunks.size())
+            chunks.push_back(newChunk());
+
+         if (c > 0 && n % chunk_size == 0) // the previous chunk is full, it is compressed now rather than when filled so that back() stays uncompressed
+            seal(chunks[c - 1]);
+
+         chunks[c].raw.get()[n % chunk_size] = value;
+         ++n;
+      }
+
+      /** Remove every value, keeping the compression setting. */
+      void clear()
+      {
+         chunks.clear();
+         n = 0;
+         cached = SIZE_MAX;
+      }
+
+      /** Preallocate chunks for a total of n values, only chunk slots are reserved when compressing. */
+      void reserve(const size_t capacity)
+      {
+         const size_t needed = (capacity + chunk_size - 1) / chunk_size;
+         chunks.reserve(needed);
+         if (codec == Codec::none)
+         {
+            while (chunks.size() < needed)
+               chunks.push_back(newChunk());
+         }
+      }
+
+      /** Set the compression applied to full chunks, including those already filled. Compressed chunks are never decompressed in place. */
+      void compress(const Codec codec)
+      {
+         this->codec = codec;
+
+         size_t full = n / chunk_size;
+         if (full > 0 && n % chunk_size == 0)
+            --full; // the chunk holding back() is left uncompressed until the next value is pushed
+
+         for (size_t c = 0; c < full; ++c)
+            seal(chunks[c]);
+      }
+
+      Codec compression() const { return codec; }
+
+      // Values are returned by copy, because a compressed chunk is decoded into a cache that is overwritten by reading another compressed chunk.
+      T operator [](const size_t i) const { return data(i / chunk_size)[i % chunk_size]; }
+      T front() const { return (*this)[0]; }
+      T back() const { return (*this)[n - 1]; }
+
+      const_iterator begin() const { return const_iterator(this, 0); }
+      const_iterator end() const { return const_iterator(this, n); }
+
+      size_t chunkCount() const { return (n + chunk_size - 1) / chunk_size; }
+
+      /** The values of chunk c, as contiguous memory. For compressed chunks the span is only valid until another compressed chunk is accessed. */
+      Span<const T> chunk(const size_t c) const { return Span<const T>(data(c), std::min(chunk_size, n - c * chunk_size)); }
+
+      /** Memory held by values, in bytes. */
+      size_t bytes() const
+      {
+         size_t total = 0;
+         for (const Chunk& chunk : chunks)
+            total += chunk.raw ? chunk_size * sizeof(T) : chunk.bits->size() * sizeof(uint64_t);
+         return total;
+      }
+   };
+
+   template <typename T>
+   const size_t Chunked<T>::chunk_size; // std::min binds chunk_size by reference, which needs a definition
+}
\ No newline at end of file
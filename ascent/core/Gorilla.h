@@ -0,0 +1,39 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+// Lossless compression of floating point histories, after Facebook's Gorilla time series database (Pelkonen et al., VLDB 2015).
+// Values are XORed with the previous value, so smooth signals produce words with long runs of leading and trailing zeros that need not be stored.
+// Times are encoded as a delta of deltas of their bit patterns, which is almost always zero for a regular time step, costing a single bit.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace asc
+{
+   namespace Gorilla
+   {
+      /** Compress n values, where each value is a group of lanes doubles (e.g. the elements of an Eigen vector), each lane is XORed against its own previous value.
+      * The compressed bits are appended to out. */
+      void encodeXor(const double* values, const size_t n, const size_t lanes, std::vector<uint64_t>& out);
+      void decodeXor(const uint64_t* in, double* values, const size_t n, const size_t lanes);
+
+      /** Compress n times, appending the compressed bits to out. */
+      void encodeDeltaOfDelta(const double* values, const size_t n, std::vector<uint64_t>& out);
+      void decodeDeltaOfDelta(const uint64_t* in, double* values, const size_t n);
+   }
+}
\ No newline at end of file
@@ -14,7 +14,10 @@
 
 #pragma once
 
+#include "RingBuffer.h"
+#include "ascent/io/BinaryTrack.h"
 #include "Simulator.h"
+#include "ToString.h"
 
 #include <deque>
 #include <map>
@@ -24,61 +27,301 @@
 
 namespace asc
 {
-   template <typename T>
-   class Parameter
+   // Type erased interface to a Parameter, allowing Vars to hold parameters of all types in a single table.
+   class ParameterBase : public ArenaAllocated // allocated from the simulator's arena if it has one (see asc::arena)
    {
-   private:
+   protected:
       bool initialized = false;
       Simulator* simulator = nullptr; // do not delete
 
    public:
-      Parameter() {}
-      Parameter(Simulator* simulator) : simulator(simulator) {}
+      ParameterBase(Simulator* simulator, const std::type_index type_index) : simulator(simulator), type_index(type_index) {}
+      virtual ~ParameterBase() {}
+
+      const std::type_index type_index; // typeid(T) of the derived Parameter<T>
 
       size_t t_begin = 0; // The index of the t_hist vector for which tracking history begins, this will be updated for history with finite steps.
-      bool infinite = false; // If true, an infinite amount of steps will be recorded.
+      bool infinite = false; // If true, an infinite amount of steps will be recorded (by the simulator's Recorder). Use setInfinite() to change.
       size_t steps = 0; // Number of steps to keep track of, if steps == 0 then no history will be maintained.
       bool clear_on_access = false; // Whether or not the old history data should be cleared when accessed.
+      bool trackable = false; // Whether or not this parameter was initialized for tracking.
+      Rate rate; // Recording rate of an infinite history. Use setRate() to change.
+      bool snapshotted = false; // Whether or not the parameter is part of the simulator's Snapshot. Use snapshot() to add it.
+
+      virtual void update() = 0;
+      virtual void setInfinite(const bool infinite) = 0;
+      virtual void setRate(const Rate& rate) = 0;
+      virtual void snapshot() = 0; // include the parameter in the simulator's Snapshot
+      virtual void serialize(Archive& archive) = 0; // save or restore the current value and history for a checkpoint (see Archive)
+      virtual size_t tBegin() const { return t_begin; }
+      virtual size_t tIndex(const size_t i) const { return t_begin + i; } // the t_hist index of the ith history element
+      virtual std::string print(const size_t i) = 0;
+      virtual void format(std::string& out, const size_t i) = 0; // append the ith history element to out, for writing rows without temporary strings
+      virtual void formatJson(std::string& out, const size_t i) = 0; // append the ith history element to out as a JSON value
+      virtual std::string type() const = 0;
+      virtual size_t length() const = 0;
+
+      virtual const void* data() const = 0; // the current value (memory handled by Module)
+      virtual std::string printCurrent() const = 0;
+
+      virtual BinaryTrack::Layout binaryLayout() const = 0;
+      virtual void writeBinary(std::ostream& stream) const = 0; // writes the history as raw scalars, see BinaryTrack
+   };
 
-      std::deque<T> x; // parameter history (std::deque is used for fast erasing of the first element)
+   template <typename T>
+   class Parameter : public ParameterBase
+   {
+   public:
+      Parameter(Simulator* simulator) : ParameterBase(simulator, typeid(T)) {}
+
+      ~Parameter()
+      {
+         if (column)
+            column->detach(); // the column may outlive this parameter, so it must stop reading from ptr
+      }
+
+      RingBuffer<T> x; // finite parameter history (a ring buffer, so dropping the oldest element and recording a new one never allocates)
+      std::shared_ptr<Column<T>> column; // infinite parameter history, recorded by the simulator's Recorder
       T* ptr = nullptr; // pointer to parameter (memory handled by Module)
       
       void update()
       {
+         if (infinite)
+            return; // recorded by the simulator's Recorder in a single pass over all infinite histories
+
          if (!initialized)
+         {
             t_begin = simulator->t_hist.size() - 1;
+            initialized = true;
+         }
 
-         if (infinite)
-            x.push_back(*ptr);
-         else if (steps > 0)
+         if (steps > 0)
          {
+            x.reserve(steps); // steps may be lengthened during runtime
+
             while (x.size() >= steps)
             {
                ++t_begin; // Increment t_hist because the starting time value is being shifted toward the more current time.
-               x.erase(x.begin());
+               x.pop_front();
             }
 
             x.push_back(*ptr);
          }
       }
 
+      void setInfinite(const bool infinite)
+      {
+         this->infinite = infinite;
+
+         if (infinite && !column)
+         {
+            column = simulator->recorder.add<T>(ptr);
+            column->setRate(rate);
+            simulator->track_time = true; // recorded rows are paired with t_hist
+         }
+         else if (!infinite && column)
+         {
+            column->detach();
+            column.reset();
+         }
+      }
+
+      void setRate(const Rate& rate)
+      {
+         this->rate = rate;
+
+         if (rate.sdt > 0.0)
+            simulator->track_samples.insert(rate.sdt);
+
+         if (column)
+            column->setRate(rate);
+      }
+
+      void snapshot()
+      {
+         simulator->snapshot.add<T>(ptr);
+         snapshotted = true;
+      }
+
+      void serialize(Archive& archive)
+      {
+         if (!Archived<T>::supported)
+            return; // types that can't be archived keep the values they were constructed with
+
+         archive(*ptr, initialized, t_begin, steps, clear_on_access, x);
+
+         Rate rate = this->rate;
+         bool infinite = this->infinite;
+         archive(rate.sdt, rate.decimation, infinite);
+         if (archive.loading())
+         {
+            setRate(rate);
+            setInfinite(infinite);
+         }
+
+         if (column)
+            column->serialize(archive);
+      }
+
+      size_t tBegin() const { return column ? column->t_begin : t_begin; }
+      size_t tIndex(const size_t i) const { return column ? column->tIndex(i) : t_begin + i; }
+
       std::deque<double> time() // Get time vector associated with x parameter history.
       {
-         const std::vector<double>& t = simulator->t_hist;
+         const Chunked<double>& t = simulator->t_hist;
          std::deque<double> th; // time history
-         size_t end = t_begin + x.size();
-         for (size_t i = t_begin; i < end; ++i)
-            th.push_back(t[i]);
+         const size_t n = length();
+         for (size_t i = 0; i < n; ++i)
+            th.push_back(t[tIndex(i)]);
          return th;
       }
 
+      double time(const size_t i) const { return simulator->t_hist[tIndex(i)]; } // time of the ith history element
+
+      /** Index of the first history element recorded at or after time t (length() if none), a binary search of the recorded times. */
+      size_t lowerBound(const double t) const
+      {
+         size_t low = 0;
+         size_t high = length();
+         while (low < high)
+         {
+            const size_t mid = low + (high - low) / 2;
+            if (time(mid) < t)
+               low = mid + 1;
+            else
+               high = mid;
+         }
+         return low;
+      }
+
+      /** Index of the first history element recorded after time t (length() if none). */
+      size_t upperBound(const double t) const
+      {
+         size_t low = 0;
+         size_t high = length();
+         while (low < high)
+         {
+            const size_t mid = low + (high - low) / 2;
+            if (time(mid) <= t)
+               low = mid + 1;
+            else
+               high = mid;
+         }
+         return low;
+      }
+
+      T value(const size_t i) const { return column ? (*column)[i] : x[i]; } // the ith history element, without copying the rest of the history
+
       std::deque<T> history()
       {
-         return x;
+         if (column)
+            return column->history();
+         return std::deque<T>(x.begin(), x.end());
+      }
+
+      std::string print(const size_t i)
+      {
+         if (column)
+            return column->print(i);
+         return ToString::print(x[i]);
+      }
+
+      void format(std::string& out, const size_t i)
+      {
+         if (column)
+            column->format(out, i);
+         else
+            ToString::append(out, x[i]);
+      }
+
+      void formatJson(std::string& out, const size_t i)
+      {
+         if (column)
+            column->formatJson(out, i);
+         else
+            ToString::appendJson(out, x[i]);
       }
 
       std::string type() const { return typeid(T).name(); }
 
-      size_t length() const { return x.size(); }
+      size_t length() const { return column ? column->size() : x.size(); }
+
+      const void* data() const { return ptr; }
+      std::string printCurrent() const { return ToString::print(*ptr); }
+
+      BinaryTrack::Layout binaryLayout() const
+      {
+         if (BinaryTrack::supported<T>())
+            return BinaryTrack::Type<T>::layout();
+         return BinaryTrack::Layout();
+      }
+
+      void writeBinary(std::ostream& stream) const
+      {
+         if (column)
+         {
+            const size_t n = column->chunkCount();
+            for (size_t c = 0; c < n; ++c)
+               BinaryTrack::write(stream, column->chunk(c));
+         }
+         else
+         {
+            auto spans = x.spans();
+            BinaryTrack::write(stream, spans.first);
+            BinaryTrack::write(stream, spans.second);
+         }
+      }
+   };
+
+   // Read-only views of a parameter's history, oldest first. They read the ring buffer or the recorded column in place rather than copying it,
+   // see values recorded after they were taken, and remain valid for the lifetime of the parameter. Elements are returned by copy (see Chunked::operator []).
+   template <typename T>
+   class HistoryView
+   {
+   private:
+      const Parameter<T>* parameter = nullptr;
+
+   public:
+      typedef T value_type;
+      typedef IndexIterator<const HistoryView, const T> const_iterator;
+      typedef const_iterator iterator;
+
+      HistoryView() {}
+      explicit HistoryView(const Parameter<T>& parameter) : parameter(&parameter) {}
+
+      size_t size() const { return parameter->length(); }
+      bool empty() const { return size() == 0; }
+
+      T operator [](const size_t i) const { return parameter->value(i); }
+      T front() const { return (*this)[0]; }
+      T back() const { return (*this)[size() - 1]; }
+
+      const_iterator begin() const { return const_iterator(this, 0); }
+      const_iterator end() const { return const_iterator(this, size()); }
+   };
+
+   template <typename T>
+   class TimeView
+   {
+   private:
+      const Parameter<T>* parameter = nullptr;
+
+   public:
+      typedef double value_type;
+      typedef IndexIterator<const TimeView, const double> const_iterator;
+      typedef const_iterator iterator;
+
+      TimeView() {}
+      explicit TimeView(const Parameter<T>& parameter) : parameter(&parameter) {}
+
+      size_t size() const { return parameter->length(); }
+      bool empty() const { return size() == 0; }
+
+      double operator [](const size_t i) const { return parameter->time(i); }
+      double front() const { return (*this)[0]; }
+      double back() const { return (*this)[size() - 1]; }
+
+      const_iterator begin() const { return const_iterator(this, 0); }
+      const_iterator end() const { return const_iterator(this, size()); }
    };
 }
\ No newline at end of file
@@ -0,0 +1,259 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// The Recorder holds the recorded (infinite) histories of a simulator's variables as columns.
+// Columns of the same type are grouped, so that recording a full step is a single pass over each type's columns, without string lookups or std::function calls.
+// Column storage is split into fixed size chunks (see Chunked) that are allocated ahead of use and never moved, so recording never copies previously recorded data.
+
+#include "Chunked.h"
+#include "RingBuffer.h"
+#include "ToString.h"
+#include "ascent/io/Archive.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <map>
+#include <memory>
+#include <typeindex>
+#include <vector>
+
+namespace asc
+{
+   // Recording rate of a tracked variable, see Module::track.
+   struct Rate
+   {
+      double sdt = 0.0; // record at multiples of the sample time step sdt (full steps are aligned to these times, as with Module::sample(sdt)), 0 records every full step
+      size_t decimation = 1; // record every nth full step that is due
+
+      static Rate sample(const double sdt) { Rate rate; rate.sdt = sdt; return rate; }
+      static Rate every(const size_t n) { Rate rate; rate.decimation = n; return rate; }
+
+      bool all() const { return sdt <= 0.0 && decimation <= 1; } // whether every full step is recorded
+
+      /** The number of rows recorded over the given number of full steps of size dt, at most. */
+      size_t rows(const size_t steps, const double dt) const
+      {
+         double n = static_cast<double>(steps);
+         if (sdt > dt && dt > 0.0)
+            n *= dt / sdt;
+         if (decimation > 1)
+            n /= static_cast<double>(decimation);
+         return static_cast<size_t>(n) + 1;
+      }
+   };
+
+   // Decides which full steps are recorded at a given Rate.
+   class Decimator
+   {
+   private:
+      size_t count = 0;
+
+   public:
+      Decimator() {}
+      Decimator(const Rate& rate) : rate(rate) {}
+
+      Rate rate;
+
+      bool due(const double t, const double EPS)
+      {
+         if (rate.sdt > 0.0 && std::abs(t - std::round(t / rate.sdt) * rate.sdt) > EPS)
+            return false;
+
+         if (rate.decimation > 1)
+            return (count++ % rate.decimation) == 0;
+
+         return true;
+      }
+
+      void serialize(Archive& archive) { archive(rate.sdt, rate.decimation, count); }
+   };
+
+   // Type erased interface to a Column.
+   class ColumnBase
+   {
+   protected:
+      size_t rows = 0; // number of recorded rows
+
+   public:
+      ColumnBase(const std::type_index type_index) : type_index(type_index) {}
+      virtual ~ColumnBase() {}
+
+      const std::type_index type_index; // typeid(T) of the derived Column<T>
+
+      size_t t_begin = 0; // The index of the t_hist vector at which recording began.
+
+      bool attached = true; // False once the recorded variable no longer exists, the column then stops recording and is dropped by the Recorder.
+      void detach() { attached = false; }
+
+      Decimator decimator; // decides which full steps are recorded
+      std::vector<size_t> t_indices; // The t_hist index of each row, only kept once the column is decimated (otherwise rows are consecutive from t_begin).
+
+      void setRate(const Rate& rate)
+      {
+         if (!rate.all() && t_indices.empty())
+         {
+            for (size_t i = 0; i < rows; ++i)
+               t_indices.push_back(t_begin + i);
+         }
+         decimator = Decimator(rate);
+      }
+
+      size_t tIndex(const size_t i) const { return t_indices.empty() ? t_begin + i : t_indices[i]; } // the t_hist index of row i
+
+      size_t size() const { return rows; }
+
+      virtual std::string print(const size_t i) const = 0;
+      virtual void format(std::string& out, const size_t i) const = 0; // append row i to out
+      virtual void formatJson(std::string& out, const size_t i) const = 0; // append row i to out as a JSON value
+      virtual void reserve(const size_t n) = 0; // preallocate storage for n more rows
+      virtual void compress(const Codec codec) = 0;
+   };
+
+   template <typename T>
+   class Column : public ColumnBase
+   {
+   public:
+      Column(const T* source) : ColumnBase(typeid(T)), source(source) {}
+
+      const T* source; // the recorded variable (memory handled by Module)
+      Chunked<T> values;
+
+      void record(const size_t t_index)
+      {
+         if (rows == 0)
+            t_begin = t_index;
+         if (!decimator.rate.all())
+            t_indices.push_back(t_index);
+
+         values.push_back(*source);
+         ++rows;
+      }
+
+      void reserve(const size_t n) { values.reserve(rows + n); }
+      void compress(const Codec codec) { values.compress(codec); }
+
+      T operator [](const size_t i) const { return values[i]; } // a copy, see Chunked::operator []
+      T back() const { return values.back(); }
+
+      typename Chunked<T>::const_iterator begin() const { return values.begin(); }
+      typename Chunked<T>::const_iterator end() const { return values.end(); }
+
+      size_t chunkCount() const { return values.chunkCount(); }
+
+      /** The recorded rows of chunk c, as contiguous memory. */
+      Span<const T> chunk(const size_t c) const { return values.chunk(c); }
+
+      std::deque<T> history() const { return std::deque<T>(values.begin(), values.end()); }
+
+      /** Save or restore the recorded rows (see Archive), rows are restored into the column's own compression. */
+      void serialize(Archive& archive)
+      {
+         archive(t_begin, t_indices, values);
+         decimator.serialize(archive);
+         rows = values.size();
+      }
+
+      std::string print(const size_t i) const { return ToString::print((*this)[i]); }
+      void format(std::string& out, const size_t i) const { ToString::append(out, (*this)[i]); }
+      void formatJson(std::string& out, const size_t i) const { ToString::appendJson(out, (*this)[i]); }
+   };
+
+   // Type erased interface to a ColumnGroup.
+   class ColumnGroupBase
+   {
+   public:
+      virtual ~ColumnGroupBase() {}
+
+      virtual void record(const size_t t_index, const double t, const double EPS) = 0;
+      virtual void reserve(const size_t steps, const double dt, const size_t max_rows) = 0;
+      virtual void compress(const Codec codec) = 0;
+      virtual size_t size() const = 0;
+   };
+
+   // All columns of a single type.
+   template <typename T>
+   class ColumnGroup : public ColumnGroupBase
+   {
+   public:
+      std::vector<std::shared_ptr<Column<T>>> columns;
+
+      void record(const size_t t_index, const double t, const double EPS)
+      {
+         bool detached = false;
+         for (auto& column : columns)
+         {
+            if (column->attached)
+            {
+               if (column->decimator.due(t, EPS))
+                  column->record(t_index);
+            }
+            else
+               detached = true;
+         }
+
+         if (detached)
+            columns.erase(std::remove_if(columns.begin(), columns.end(), [](const std::shared_ptr<Column<T>>& column) { return !column->attached; }), columns.end());
+      }
+
+      void reserve(const size_t steps, const double dt, const size_t max_rows)
+      {
+         for (auto& column : columns)
+            column->reserve(std::min(column->decimator.rate.rows(steps, dt), max_rows));
+      }
+
+      void compress(const Codec codec)
+      {
+         for (auto& column : columns)
+            column->compress(codec);
+      }
+
+      size_t size() const { return columns.size(); }
+   };
+
+   class Recorder
+   {
+   private:
+      const Chunked<double>& t_hist; // the simulator's time history, which the recorded rows are paired with
+      std::map<std::type_index, std::unique_ptr<ColumnGroupBase>> groups;
+      Codec codec = Codec::none;
+
+   public:
+      Recorder(const Chunked<double>& t_hist) : t_hist(t_hist) {}
+
+      size_t max_reserve = 1 << 13; // Limit on the number of rows preallocated per column by reserve(), so that long runs and large models don't commit their memory up front (columns grow a chunk at a time without copying regardless).
+
+      /** Add a column that records the source variable. The column is shared with the caller, who must detach() it before the source is destroyed. */
+      template <typename T>
+      std::shared_ptr<Column<T>> add(const T* source)
+      {
+         auto& group = groups[typeid(T)];
+         if (!group)
+            group = std::make_unique<ColumnGroup<T>>();
+
+         auto column = std::make_shared<Column<T>>(source);
+         column->compress(codec);
+         static_cast<ColumnGroup<T>&>(*group).columns.push_back(column);
+         return column;
+      }
+
+      void record(const double EPS); // record a row for every attached column that is due, EPS is the simulator's time tolerance
+      void reserve(const size_t steps, const double dt); // preallocate storage in every column for the rows it records over the given number of full steps of size dt (see Rate::rows)
+      void compress(const Codec codec); // compression for every column, including those added later (types that aren't made of doubles are left uncompressed)
+
+      size_t size() const; // number of columns
+   };
+}
\ No newline at end of file
@@ -0,0 +1,269 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// RingBuffer is a contiguous circular buffer for time histories.
+// Removing the oldest element and pushing a new one are O(1) and never allocate once the capacity has been reserved.
+// When full, push_back grows the capacity (doubling), so the same container serves both finite and infinite histories.
+// The elements are always stored in at most two contiguous spans, which algorithms can iterate over directly.
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace asc
+{
+   // A contiguous view of elements.
+   template <typename T>
+   class Span
+   {
+   private:
+      T* ptr = nullptr;
+      size_t n = 0;
+
+   public:
+      Span() {}
+      Span(T* ptr, const size_t n) : ptr(ptr), n(n) {}
+
+      T* data() const { return ptr; }
+      size_t size() const { return n; }
+      bool empty() const { return n == 0; }
+
+      T* begin() const { return ptr; }
+      T* end() const { return ptr + n; }
+
+      T& operator [](const size_t i) const { return ptr[i]; }
+   };
+
+   // Random access iterator for any container with operator [], which iterates by index.
+   // Dereferencing returns whatever the container's operator [] returns, which is a copy for containers that don't hold their values in stable storage (e.g. Chunked).
+   template <typename Container, typename Value>
+   class IndexIterator
+   {
+   private:
+      Container* container = nullptr;
+      size_t i = 0;
+
+   public:
+      typedef std::random_access_iterator_tag iterator_category;
+      typedef typename std::remove_const<Value>::type value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef Value* pointer;
+      typedef decltype(std::declval<Container&>()[0]) reference;
+
+      IndexIterator() {}
+      IndexIterator(Container* container, const size_t i) : container(container), i(i) {}
+
+      operator IndexIterator<const Container, const Value>() const { return IndexIterator<const Container, const Value>(container, i); }
+
+      size_t index() const { return i; }
+
+      reference operator * () const { return (*container)[i]; }
+      pointer operator -> () const { return &(*container)[i]; }
+      reference operator [](const difference_type d) const { return (*container)[i + d]; }
+
+      IndexIterator& operator ++ () { ++i; return *this; }
+      IndexIterator& operator -- () { --i; return *this; }
+      IndexIterator operator ++ (int) { IndexIterator it = *this; ++i; return it; }
+      IndexIterator operator -- (int) { IndexIterator it = *this; --i; return it; }
+
+      IndexIterator& operator += (const difference_type d) { i += d; return *this; }
+      IndexIterator& operator -= (const difference_type d) { i -= d; return *this; }
+      IndexIterator operator + (const difference_type d) const { return IndexIterator(container, i + d); }
+      IndexIterator operator - (const difference_type d) const { return IndexIterator(container, i - d); }
+      friend IndexIterator operator + (const difference_type d, const IndexIterator& it) { return it + d; }
+      difference_type operator - (const IndexIterator& rhs) const { return static_cast<difference_type>(i) - static_cast<difference_type>(rhs.i); }
+
+      bool operator == (const IndexIterator& rhs) const { return i == rhs.i; }
+      bool operator != (const IndexIterator& rhs) const { return i != rhs.i; }
+      bool operator < (const IndexIterator& rhs) const { return i < rhs.i; }
+      bool operator > (const IndexIterator& rhs) const { return i > rhs.i; }
+      bool operator <= (const IndexIterator& rhs) const { return i <= rhs.i; }
+      bool operator >= (const IndexIterator& rhs) const { return i >= rhs.i; }
+   };
+
+   template <typename T>
+   class RingBuffer
+   {
+   private:
+      std::unique_ptr<T[]> buffer; // new T[] is used (rather than std::vector) so that Eigen's aligned operator new[] is respected
+      size_t cap = 0; // capacity
+      size_t head = 0; // buffer index of the oldest element
+      size_t n = 0; // number of elements
+
+      size_t index(const size_t i) const // buffer index of the ith element
+      {
+         const size_t k = head + i;
+         return (k < cap) ? k : k - cap;
+      }
+
+      void reallocate(const size_t capacity) // linearizes the elements into a new buffer, keeping the newest elements if shrinking
+      {
+         std::unique_ptr<T[]> resized(capacity > 0 ? new T[capacity] : nullptr);
+
+         const size_t kept = std::min(n, capacity);
+         const size_t skipped = n - kept;
+         for (size_t i = 0; i < kept; ++i)
+            resized[i] = std::move(buffer[index(skipped + i)]);
+
+         buffer = std::move(resized);
+         cap = capacity;
+         head = 0;
+         n = kept;
+      }
+
+   public:
+      typedef T value_type;
+      typedef IndexIterator<RingBuffer, T> iterator;
+      typedef IndexIterator<const RingBuffer, const T> const_iterator;
+
+      RingBuffer() {}
+      explicit RingBuffer(const size_t capacity) { reserve(capacity); }
+
+      RingBuffer(const RingBuffer& rhs) { *this = rhs; }
+      RingBuffer(RingBuffer&& rhs) = default;
+
+      RingBuffer& operator = (const RingBuffer& rhs)
+      {
+         if (this != &rhs)
+         {
+            buffer.reset(rhs.cap > 0 ? new T[rhs.cap] : nullptr);
+            cap = rhs.cap;
+            head = 0;
+            n = rhs.n;
+            for (size_t i = 0; i < n; ++i)
+               buffer[i] = rhs[i];
+         }
+         return *this;
+      }
+
+      RingBuffer& operator = (RingBuffer&& rhs) = default;
+
+      size_t size() const { return n; }
+      size_t capacity() const { return cap; }
+      bool empty() const { return n == 0; }
+      bool full() const { return n == cap; }
+
+      /** Grow the capacity, preserving all elements. Does nothing if the capacity is already large enough. */
+      void reserve(const size_t capacity)
+      {
+         if (capacity > cap)
+            reallocate(capacity);
+      }
+
+      /** Set the exact capacity. When shrinking, the oldest elements are discarded. */
+      void setCapacity(const size_t capacity)
+      {
+         if (capacity != cap)
+            reallocate(capacity);
+      }
+
+      void push_back(const T& value)
+      {
+         if (n == cap)
+            reallocate(std::max<size_t>(2 * cap, 8));
+
+         buffer[index(n)] = value;
+         ++n;
+      }
+
+      void pop_front()
+      {
+         if (n > 0)
+         {
+            ++head;
+            if (head == cap)
+               head = 0;
+            --n;
+         }
+      }
+
+      void pop_back()
+      {
+         if (n > 0)
+            --n;
+      }
+
+      void clear()
+      {
+         head = 0;
+         n = 0;
+      }
+
+      /** Erase an element, O(n) because the following elements are shifted. */
+      iterator erase(const_iterator position)
+      {
+         const size_t i = position.index();
+         for (size_t j = i; j + 1 < n; ++j)
+            (*this)[j] = std::move((*this)[j + 1]);
+         pop_back();
+         return iterator(this, i);
+      }
+
+      T& operator [](const size_t i) { return buffer[index(i)]; }
+      const T& operator [](const size_t i) const { return buffer[index(i)]; }
+
+      T& at(const size_t i)
+      {
+         if (i >= n)
+            throw std::out_of_range("RingBuffer::at");
+         return (*this)[i];
+      }
+
+      const T& at(const size_t i) const
+      {
+         if (i >= n)
+            throw std::out_of_range("RingBuffer::at");
+         return (*this)[i];
+      }
+
+      T& front() { return buffer[head]; }
+      const T& front() const { return buffer[head]; }
+      T& back() { return buffer[index(n - 1)]; }
+      const T& back() const { return buffer[index(n - 1)]; }
+
+      iterator begin() { return iterator(this, 0); }
+      iterator end() { return iterator(this, n); }
+      const_iterator begin() const { return const_iterator(this, 0); }
+      const_iterator end() const { return const_iterator(this, n); }
+      const_iterator cbegin() const { return begin(); }
+      const_iterator cend() const { return end(); }
+
+      /** The elements as two contiguous spans, oldest first. The second span is empty if the storage hasn't wrapped. */
+      std::pair<Span<const T>, Span<const T>> spans() const
+      {
+         const T* data = buffer.get();
+         if (head + n <= cap)
+            return std::make_pair(Span<const T>(data + head, n), Span<const T>(data, 0));
+
+         const size_t first = cap - head;
+         return std::make_pair(Span<const T>(data + head, first), Span<const T>(data, n - first));
+      }
+
+      std::pair<Span<T>, Span<T>> spans()
+      {
+         T* data = buffer.get();
+         if (head + n <= cap)
+            return std::make_pair(Span<T>(data + head, n), Span<T>(data, 0));
+
+         const size_t first = cap - head;
+         return std::make_pair(Span<T>(data + head, first), Span<T>(data, n - first));
+      }
+   };
+}
\ No newline at end of file
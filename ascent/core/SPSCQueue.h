@@ -0,0 +1,79 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+// SPSCQueue is a bounded, lock-free queue for exactly one producer thread and one consumer thread.
+// push() and pop() never block and never allocate, they return false when the queue is full or empty respectively.
+
+#include <atomic>
+#include <memory>
+
+namespace asc
+{
+   template <typename T>
+   class SPSCQueue
+   {
+   private:
+      static const size_t cache_line = 64;
+
+      const size_t n; // number of slots (one slot is always left empty to distinguish a full queue from an empty one)
+      std::unique_ptr<T[]> slots;
+
+      // head and tail are kept on separate cache lines so that the producer and consumer don't contend (padding rather than alignas, which heap allocation doesn't honor before C++17)
+      char padding0[cache_line];
+      std::atomic<size_t> head{ 0 }; // next slot to pop, written by the consumer
+      char padding1[cache_line - sizeof(std::atomic<size_t>)];
+      std::atomic<size_t> tail{ 0 }; // next slot to push, written by the producer
+      char padding2[cache_line - sizeof(std::atomic<size_t>)];
+
+      size_t next(const size_t i) const { return (i + 1 == n) ? 0 : i + 1; }
+
+   public:
+      explicit SPSCQueue(const size_t capacity) : n(capacity + 1), slots(new T[capacity + 1]) {}
+
+      SPSCQueue(const SPSCQueue&) = delete;
+      SPSCQueue& operator = (const SPSCQueue&) = delete;
+
+      size_t capacity() const { return n - 1; }
+
+      /** Producer only. */
+      bool push(const T& value)
+      {
+         const size_t i = tail.load(std::memory_order_relaxed);
+         const size_t j = next(i);
+         if (j == head.load(std::memory_order_acquire))
+            return false; // full
+
+         slots[i] = value;
+         tail.store(j, std::memory_order_release);
+         return true;
+      }
+
+      /** Consumer only. */
+      bool pop(T& value)
+      {
+         const size_t i = head.load(std::memory_order_relaxed);
+         if (i == tail.load(std::memory_order_acquire))
+            return false; // empty
+
+         value = std::move(slots[i]);
+         head.store(next(i), std::memory_order_release);
+         return true;
+      }
+
+      bool empty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+   };
+}
\ No newline at end of file
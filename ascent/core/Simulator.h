@@ -14,8 +14,13 @@
 
 #pragma once
 
+#include "ascent/core/Arena.h"
 #include "ascent/core/DynamicMap.h"
+#include "ascent/core/Recorder.h"
+#include "ascent/core/Snapshot.h"
 #include "ascent/io/ChaiEngine.h"
+#include "ascent/io/StreamWriter.h"
+#include "ascent/io/TelemetryServer.h"
 
 #include "ascent/core/State.h"
 #include "ascent/core/Stepper.h"
@@ -23,6 +28,7 @@
 
 #include <functional>
 #include <iostream>
+#include <set>
 #include <string>
 
 namespace asc
@@ -30,6 +36,8 @@ namespace asc
    template <typename T>
    class Link;
 
+   class DelayBase;
+
    enum class Phase
    {
       setup,
@@ -61,11 +69,22 @@ namespace asc
       bool setError(const std::string& description); // always returns false
 
       bool track_time = false;
-      std::vector<double> t_hist; // time history (used to interpolate and provide time pairing with Parameter history)
+      Chunked<double> t_hist; // time history (used to interpolate and provide time pairing with Parameter history)
+      Recorder recorder{ t_hist }; // infinite histories of tracked variables, recorded as columns
+      void compressHistory(const bool compress); // losslessly compress t_hist and recorded histories (see Chunked)
+      std::set<double> track_samples; // sample time steps of tracked variables (see Rate), full steps are aligned to these times
+      Snapshot snapshot; // step coherent copies of selected variables for other threads, published after report() (see Module::snapshot)
+      std::shared_ptr<Arena> arena; // modules created through Link, their integrated states and their variables are allocated from this if set (see asc::arena)
+      std::vector<DelayBase*> delays; // recorded once per full step, and full steps are aligned to their discontinuities (see DelayBuffer)
 
       bool run(const double dt_base, const double t_end);
       bool run() { return run(dtp, t_end); }
 
+      bool checkpoint(std::ostream& stream); // save the simulator and all of its modules, between runs or from report() (see Module::checkpoint)
+      bool restore(std::istream& stream); // restore a checkpoint into modules constructed again in the same order, between runs (see Module::restore)
+      bool restore(Archive& archive);
+      void serialize(Archive& archive); // throws std::runtime_error if a restored checkpoint doesn't match the simulator
+
       bool sample() { return (kpass == 0); }
       bool sample(double sdt);
       bool event(double t_event);
@@ -92,6 +111,11 @@ namespace asc
       module_map propagate;
 
       module_map trackers;
+      module_map streamers; // modules streaming their tracked data to files while running
+      module_map publishers; // modules publishing their tracked variables to shared memory (see Module::shareTelemetry)
+
+      std::shared_ptr<StreamWriter> stream_writer; // created when a module first streams its files
+      std::shared_ptr<TelemetryServer> telemetry; // serves JsonAPI requests to other processes, see Module::serveTelemetry
 
       std::vector<asc::Module*> to_add; // modules are temporarily held here when added during runtime to avoid invalidating the module_map iterator for the current phase
 
@@ -109,6 +133,8 @@ namespace asc
       void createFiles(); // create end of simulation run files (i.e. tracked parameter files)
 
       Phase phase = Phase::setup;
+      size_t epoch = 1; // advanced whenever a phase begins or ends (see Module::ran)
+      void setPhase(const Phase phase) { this->phase = phase; ++epoch; }
 
       void propagateStates(); // calls Module propagateStates() methods
       void updateClock();
@@ -131,6 +157,9 @@ namespace asc
       std::unique_ptr<State> integrator;
       Stepper stepper;
 
+      std::unique_ptr<State> integrator_change; // the integrator to be switched to at the end of the current full step
+      void changeIntegrator(); // switches to integrator_change and rebuilds all module states from their current x and xd
+
       bool tick0 = true; // Very first tick of the simulation, used to avoid overlapping between tickfirst and ticklast tracking calls for additional run() calls.
 
       double EPS = 1e-8;
@@ -0,0 +1,136 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// Snapshot holds step coherent copies of selected variables, published by the simulation thread at the end of each full step (after report()),
+// so that other threads (e.g. a GUI or JsonAPI) can read them while the simulation runs, without locks and without stalling the simulation thread.
+//
+// The copies are kept in a few slots. A reader pins the most recently published slot for as long as it holds a View, and the writer publishes into a slot that isn't pinned.
+// A slot's state counts its readers, and the writer claims a slot only when that count is zero (by compare and swap), so a pinned slot is never written.
+// If every other slot is pinned, the step isn't published rather than waiting, and readers keep seeing the previous step.
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace asc
+{
+   class Snapshot
+   {
+   private:
+      struct ValueBase
+      {
+         virtual ~ValueBase() {}
+         virtual void copy() = 0;
+         virtual void detach() = 0;
+      };
+
+      template <typename T>
+      struct Value : public ValueBase
+      {
+         Value(const T* source) : source(source), value(*source) {}
+
+         const T* source; // nullptr once the variable no longer exists, the last copy is kept
+         T value;
+
+         void copy() { if (source) value = *source; }
+         void detach() { source = nullptr; }
+      };
+
+      struct Slot
+      {
+         std::atomic<uint32_t> state{ 0 }; // number of readers, plus the writing flag while being written
+         uint64_t step = 0; // number of the published step, zero if the slot has never been published
+         double t = 0.0;
+         std::vector<std::unique_ptr<ValueBase>> values;
+      };
+
+      static const uint32_t writing = 0x80000000u;
+      static const size_t n_slots = 4;
+
+      Slot slots[n_slots];
+      std::atomic<size_t> latest{ 0 }; // the most recently published slot
+      std::unordered_map<const void*, size_t> indices; // index into Slot::values by variable address
+      uint64_t published = 0;
+      size_t skipped = 0;
+
+   public:
+      // A pinned, published slot. The slot isn't written while the View exists, so Views should be short lived.
+      class View
+      {
+      private:
+         const Snapshot* snapshot = nullptr;
+         Slot* slot = nullptr;
+
+      public:
+         View() {}
+         View(const Snapshot* snapshot, Slot* slot) : snapshot(snapshot), slot(slot) {}
+         ~View() { if (slot) slot->state.fetch_sub(1, std::memory_order_release); }
+
+         View(View&& rhs) : snapshot(rhs.snapshot), slot(rhs.slot) { rhs.slot = nullptr; }
+         View(const View&) = delete;
+         View& operator = (const View&) = delete;
+
+         explicit operator bool() const { return slot != nullptr; } // false if nothing has been published
+
+         uint64_t step() const { return slot->step; }
+         double t() const { return slot->t; }
+
+         /** The snapshot copy of the variable at source, nullptr if it isn't part of the snapshot (or isn't of type T). */
+         template <typename T>
+         const T* get(const T* source) const
+         {
+            auto it = snapshot->indices.find(source);
+            if (it == snapshot->indices.end())
+               return nullptr;
+
+            auto value = dynamic_cast<const Value<T>*>(slot->values[it->second].get());
+            return value ? &value->value : nullptr;
+         }
+      };
+
+      Snapshot() {}
+      Snapshot(const Snapshot&) = delete;
+      Snapshot& operator = (const Snapshot&) = delete;
+
+      /** Include the variable at source in the snapshot. Changes the snapshot's structure, so it must not be called while other threads read (e.g. add variables before running). */
+      template <typename T>
+      void add(const T* source)
+      {
+         if (indices.count(source))
+            return;
+
+         indices[source] = slots[0].values.size();
+         for (Slot& slot : slots)
+            slot.values.emplace_back(new Value<T>(source));
+      }
+
+      /** Stop copying the variable at source, which no longer exists. Readers keep its last copy. */
+      void detach(const void* source);
+
+      bool empty() const { return indices.empty(); }
+      bool contains(const void* source) const { return indices.count(source) > 0; }
+
+      /** Copy every variable into an unpinned slot and make it the latest, called by the simulation thread. */
+      void publish(const double t);
+
+      /** Pin the latest published slot, callable from any thread. The View is empty (false) if nothing has been published. */
+      View read();
+
+      size_t skippedSteps() const { return skipped; } // steps not published because readers pinned every other slot
+   };
+}
\ No newline at end of file
@@ -14,9 +14,12 @@
 
 #pragma once
 
+#include "ascent/core/Arena.h"
+#include "ascent/io/Archive.h"
+
 namespace asc
 {
-   class State
+   class State : public ArenaAllocated // allocated from the simulator's arena if it has one (see asc::arena)
    {
    public:
       State(double &x, double &xd) : x(x), xd(xd) {}
@@ -29,6 +32,8 @@ namespace asc
       virtual double optimalTimeStep() = 0;
       virtual bool adaptive() { return false; } // Whether this is an adaptive integrator (NOT FSAL), like Dormand Prince 87 (DOPRI87).
       virtual bool adaptiveFSAL() { return false; } // Whether this is a First Same As Last (FSAL) adaptive integration scheme (i.e. Dormand Prince 45 (DOPRI45)).
+      virtual void serialize(Archive& archive) { archive(x, xd, tolerance); } // Save or restore the state for a checkpoint, integrators add their stage and multistep history.
+      virtual void serializeClock(Archive& archive) {} // Save or restore what updateClock() counts, for the simulator's integrator (which updates the clock, but holds no state).
 
       double &x, &xd; // xd is the derivative of x
       double tolerance; // allows adaptive step size tolerance to be set uniquely for every state
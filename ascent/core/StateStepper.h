@@ -27,6 +27,7 @@ namespace asc
       StateStepper(double &x, double& xd, Stepper& stepper) : State(x, xd), Stepper(stepper) {}
 
       virtual double optimalTimeStep() { return dt; } // For adaptive step algorithms
+      virtual void serialize(Archive& archive) { State::serialize(archive); archive(x0); }
 
       double x0;
    };
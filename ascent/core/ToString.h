@@ -14,7 +14,14 @@
 
 #pragma once
 
-#include "Parameter.h"
+#include "ascent/io/Format.h"
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+#include <typeindex>
+#include <vector>
 
 #include <Eigen/Dense>
 
@@ -28,7 +35,7 @@ namespace asc
       inline typename std::enable_if<std::is_arithmetic<T>::value || std::is_integral<T>::value, void>::type registerType()
       {
          auto& print_map = printMap();
-         print_map[typeid(T)] = [&](void* x) { return std::to_string(*static_cast<T*>(x)); };
+         print_map[typeid(T)] = [&](void* x) { return Format::toString(*static_cast<T*>(x)); };
       }
 
       template <typename T>
@@ -43,21 +50,7 @@ namespace asc
       {
          auto& print_map = printMap();
 
-         print_map[typeid(T)] = [&](void* x) {
-            T& vec = *static_cast<T*>(x);
-
-            std::string output = "";
-
-            size_t n = vec.size();
-            for (size_t i = 0; i < n; ++i)
-            {
-               output += std::to_string(vec[i]);
-               if (i < n - 1) // not the last parameter
-                  output += ",";
-            }
-
-            return output;
-         };
+         print_map[typeid(T)] = [&](void* x) { return Format::toString(*static_cast<T*>(x)); };
       }
 
       template <typename T> inline typename std::enable_if<std::is_same<T, std::vector<bool>>::value, void>::type registerType() { registerVectorType<T>(); }
@@ -74,21 +67,7 @@ namespace asc
       {
          auto& print_map = printMap();
 
-         print_map[typeid(T)] = [&](void* x) {
-            T matrix = *static_cast<T*>(x);
-
-            std::string output = "";
-
-            size_t n = matrix.array().size();
-            for (size_t i = 0; i < n; ++i)
-            {
-               output += std::to_string(matrix.array()(i));
-               if (i < n - 1) // not the last parameter
-                  output += ",";
-            }
-
-            return output;
-         };
+         print_map[typeid(T)] = [&](void* x) { return Format::toString(*static_cast<T*>(x)); };
       }
 
       template <typename T> inline typename std::enable_if<std::is_same<T, Eigen::Vector2d>::value, void>::type registerType() { registerEigen<T>(); }
@@ -158,14 +137,28 @@ namespace asc
       }
 
       template <typename T>
-      inline std::string print(T& x)
+      inline std::string print(const T& x)
       {
          auto& print_map = printMap();
 
          if (print_map.count(typeid(T)))
-            return print_map[typeid(T)](&x);
+            return print_map[typeid(T)](const_cast<T*>(&x)); // registered functions don't modify x
 
          return "Type not registered for printing: " + static_cast<std::string>(typeid(T).name());
       }
+
+      /** Append x to out. Types supported by Format are formatted directly (resolved at compile time), other types go through the registered print functions. */
+      template <typename T>
+      inline typename std::enable_if<Format::Formattable<T>::value>::type append(std::string& out, const T& x) { Format::append(out, x); }
+
+      template <typename T>
+      inline typename std::enable_if<!Format::Formattable<T>::value>::type append(std::string& out, const T& x) { out += print(x); }
+
+      /** Append x to out as a JSON value, types not supported by Format are written as the string from their registered print function. */
+      template <typename T>
+      inline typename std::enable_if<Format::Formattable<T>::value>::type appendJson(std::string& out, const T& x) { Format::appendJson(out, x); }
+
+      template <typename T>
+      inline typename std::enable_if<!Format::Formattable<T>::value>::type appendJson(std::string& out, const T& x) { Format::appendJson(out, print(x)); }
    }
 }
\ No newline at end of file
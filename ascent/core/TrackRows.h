@@ -0,0 +1,48 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// TrackRows walks the rows of tracked output files. Variables can be tracked at different rates (see Module::track(var, Rate)) or from different times,
+// so each row is a recorded time, and a variable's cell is only filled when the variable has a sample recorded at that time.
+
+#include <cstddef>
+#include <vector>
+
+namespace asc
+{
+   class ParameterBase;
+
+   class TrackRows
+   {
+   private:
+      const std::vector<ParameterBase*>& columns;
+      std::vector<size_t> lengths;
+      std::vector<size_t> next; // next sample of each column
+      std::vector<char> filled; // whether each column has a sample in the current row
+
+   public:
+      TrackRows(const std::vector<ParameterBase*>& columns);
+
+      size_t t_index = 0; // t_hist index of the current row
+
+      /** Move to the next row, returns false once every column's samples have been written. */
+      bool advance();
+
+      bool has(const size_t j) const { return filled[j] != 0; } // whether column j has a sample in the current row
+      size_t sample(const size_t j) const { return next[j]; } // history index of column j's sample in the current row, only valid if has(j)
+
+      bool aligned() const; // whether every column has a sample in every row, as when all variables are tracked at the same rate from the same time
+   };
+}
\ No newline at end of file
@@ -15,136 +15,178 @@
 #pragma once
 
 #include "Parameter.h"
-#include "ToString.h"
 
 #include <iostream>
 #include <functional>
 #include <map>
 #include <sstream>
 #include <memory>
+#include <unordered_map>
 
 namespace asc
 {
+   /** A stable, typed handle to a variable defined in Vars.
+   * Handles are obtained once by name (or returned from Module::define) and afterwards access the variable without any string lookup.
+   * A handle remains valid for the lifetime of the Module that defined the variable.
+   */
+   template <typename T>
+   class Var
+   {
+   private:
+      T* ptr = nullptr; // pointer to the variable (memory handled by Module)
+      Parameter<T>* parameter = nullptr; // do not delete, owned by Vars
+
+   public:
+      Var() {}
+      Var(const size_t index, Parameter<T>* parameter) : ptr(parameter->ptr), parameter(parameter), index(index) {}
+
+      size_t index = 0; // index into the variable table of the Vars that owns this variable
+
+      T get() const { return *ptr; }
+      void set(const T& x) const { *ptr = x; }
+
+      T& operator * () const { return *ptr; }
+      T* operator -> () const { return ptr; }
+      operator T& () const { return *ptr; }
+
+      bool valid() const { return (ptr != nullptr); }
+
+      HistoryView<T> history() const { return HistoryView<T>(*parameter); } // the recorded values, read in place
+      TimeView<T> time() const { return TimeView<T>(*parameter); } // the times of the recorded values, read in place
+
+      Parameter<T>& param() const { return *parameter; }
+   };
+
    class Vars
    {
       friend class Module;
    private:
       Simulator& simulator;
+      std::shared_ptr<Arena> arena; // keeps the simulator's arena (if any) alive until the parameters allocated from it are destroyed
+
+      // The variable table, Var<T>::index indexes into this vector.
+      std::vector<std::unique_ptr<ParameterBase>, ArenaAllocator<std::unique_ptr<ParameterBase>>> parameters;
 
-      // stores pointers to maps of Parameters
-      std::map<std::type_index, void*> maps;
-      std::map<std::type_index, std::function<void()>> delete_map;
+      // String lookup layer on top of the variable table.
+      std::unordered_map<std::string, size_t, std::hash<std::string>, std::equal_to<std::string>, ArenaAllocator<std::pair<const std::string, size_t>>> indices;
 
       // A vector of all initialized object typeid(T).name() definitions and variable names. e.g. ("double", "height")
       std::vector<std::pair<std::string, std::string>> names;
 
-      std::map<std::string, std::function<void()>> update_map;
-      std::map<std::string, std::function<std::string(const size_t i)>> print_map;
-      std::map<std::string, std::function<std::string()>> type_map;
-      std::map<std::string, std::function<size_t()>> length_map;
-      std::map<std::string, std::function<size_t()>> t_begin_map;
-      std::map<std::string, std::function<void(size_t steps)>> steps_map;
-      std::map<std::string, std::function<void(bool infinite)>> steps_infinite_map;
-
-      template <typename T>
-      std::map<std::string, Parameter<T>>& getMap()
+      // Returns nullptr (and sets an error) if the variable doesn't exist.
+      ParameterBase* find(const std::string& id)
       {
-         return *static_cast<std::map<std::string, Parameter<T>>*>(maps[typeid(T)]);
+         auto p = indices.find(id);
+         if (p != indices.end())
+            return parameters[p->second].get();
+
+         simulator.setError("Variable <" + id + "> could not be located.");
+         return nullptr;
       }
 
       template <typename T>
-      T* getPtr(const std::string &id)
+      Parameter<T>* find(const std::string& id)
       {
-         if (maps.count(typeid(T)))
+         ParameterBase* base = find(id);
+         if (base)
          {
-            auto& map = getMap<T>();
-
-            auto p = map.find(id);
-            if (p != map.end())
-               return p->second.ptr;
+            if (base->type_index == typeid(T))
+               return static_cast<Parameter<T>*>(base);
             else
-               simulator.setError("Variable <" + id + "> could not be located.");
+               simulator.setError("Variable <" + id + "> is not of type <" + typeid(T).name() + ">.");
          }
-         else
-            simulator.setError((std::string)"No variables of type <" + typeid(T).name() + "> were set for access.");
 
          return nullptr;
       }
 
-   public:
-      Vars(Simulator& simulator) : simulator(simulator) {}
-      
-      ~Vars()
+      // Returns nullptr (and sets an error) if the variable wasn't initialized for tracking. The error message is only built on failure.
+      ParameterBase* findTrackable(const std::string& id, const char* caller)
       {
-         for (auto p : maps)
-            delete_map[p.first]();
+         auto p = indices.find(id);
+         if (p != indices.end() && parameters[p->second]->trackable)
+            return parameters[p->second].get();
+
+         simulator.setError(std::string("Access failure in Vars::") + caller + " for id <" + id + ">");
+         return nullptr;
       }
 
       template <typename T>
-      Parameter<T>& initNoTrack(const std::string &id, T &x)
+      T* getPtr(const std::string &id)
       {
-         if (maps.count(typeid(T)) == 0) // if this type hasn't been initialized before, then create a new container for this type
-         {
-            auto map_ptr = new std::map<std::string, Parameter<T>>();
-            maps[typeid(T)] = map_ptr;
-            delete_map[typeid(T)] = [=] () { delete map_ptr; };
-         }
+         Parameter<T>* parameter = find<T>(id);
+         if (parameter)
+            return parameter->ptr;
+
+         return nullptr;
+      }
 
-         auto& map = getMap<T>();
+   public:
+      Vars(Simulator& simulator) : simulator(simulator), arena(simulator.arena), parameters(arena), indices(0, arena) {}
 
-         auto p = map.find(id);
-         if (p != map.end())
+      template <typename T>
+      Var<T> initNoTrack(const std::string &id, T &x)
+      {
+         if (indices.count(id))
             simulator.setError("id of <" + id + "> was already initialized. Overwriting.");
 
          names.push_back(std::pair<std::string, std::string>(typeid(T).name(), id));
 
-         Parameter<T> param(&simulator);
-         param.ptr = &x;
-         map.emplace(id, param); // copy of Parameter param made (copy is legitimate because its pointers are copied)
-
-         Parameter<T>& ref = map[id]; // get reference to copy
-
-         type_map[id] = [&]() -> std::string { return ref.type(); };
+         size_t index = parameters.size();
+         Arena::Scope scope(arena.get());
+         auto param = new Parameter<T>(&simulator);
+         param->ptr = &x;
+         parameters.emplace_back(param);
+         indices[id] = index;
 
-         return ref;
+         return Var<T>(index, param);
       }
 
       template <typename T>
-      void init(const std::string& id, T& x, size_t steps)
+      Var<T> init(const std::string& id, T& x, size_t steps)
       {
-         Parameter<T>& ref = initNoTrack(id, x);
+         Var<T> var = initNoTrack(id, x);
 
+         Parameter<T>& ref = var.param();
          ref.steps = steps;
+         ref.trackable = true;
 
-         update_map[id] = [&]() { ref.update(); };
-         length_map[id] = [&]() -> size_t { return ref.length(); };
-         t_begin_map[id] = [&]() -> size_t { return ref.t_begin; };
-         steps_map[id] = [&](size_t steps) { ref.steps = steps; };
-         steps_infinite_map[id] = [&](bool inifinite) { ref.infinite = inifinite; };
+         return var;
+      }
+
+      /** Get a handle to a variable, the returned handle can be stored for lookup free access. */
+      template <typename T>
+      Var<T> handle(const std::string& id)
+      {
+         Parameter<T>* parameter = find<T>(id);
+         if (parameter)
+            return Var<T>(indices[id], parameter);
 
-         print_map[id] = [&](const size_t i) -> std::string { return ToString::print(ref.x[i]); };
+         return Var<T>();
       }
 
       bool trackable(const std::string& id)
       {
-         if (update_map.count(id))
-            return true;
+         auto p = indices.find(id);
+         if (p != indices.end())
+            return parameters[p->second]->trackable;
          
          return false;
       }
 
       void update(const std::string& id)
       {
-         if (update_map.count(id))
-            update_map[id]();
-         else
-            simulator.setError("Access failure in Vars::update(const std::string& id)");
+         ParameterBase* parameter = findTrackable(id, "update(const std::string& id)");
+         if (parameter)
+            parameter->update();
       }
 
       void update() // updates all tracked parameters
       {
-         for (auto& p : update_map)
-            p.second();
+         for (auto& parameter : parameters)
+         {
+            if (parameter->trackable)
+               parameter->update();
+         }
       }
 
       std::string print(const std::string& id)
@@ -155,33 +197,34 @@ namespace asc
 
       std::string print(const std::string& id, const size_t i)
       {
-         if (print_map.count(id))
-            return print_map[id](i);
-         simulator.setError("Access failure in Vars::print(const std::string& id, const size_t i)");
+         ParameterBase* parameter = findTrackable(id, "print(const std::string& id, const size_t i)");
+         if (parameter)
+            return parameter->print(i);
          return "";
       }
 
       std::string type(const std::string& id)
       {
-         if (type_map.count(id))
-            return type_map[id]();
+         auto p = indices.find(id);
+         if (p != indices.end())
+            return parameters[p->second]->type();
          simulator.setError("Access failure in Vars::type(const std::string& id)");
          return "";
       }
 
       size_t length(const std::string& id) // returns length of id's Parameter history
       {
-         if (length_map.count(id))
-            return length_map[id]();
-         simulator.setError("Access failure in Vars::length(const std::string& id)");
+         ParameterBase* parameter = findTrackable(id, "length(const std::string& id)");
+         if (parameter)
+            return parameter->length();
          return 0;
       }
 
       size_t tBegin(const std::string& id)
       {
-         if (t_begin_map.count(id))
-            return t_begin_map[id]();
-         simulator.setError("Access failure in Vars::tBegin(const std::string& id)");
+         ParameterBase* parameter = findTrackable(id, "tBegin(const std::string& id)");
+         if (parameter)
+            return parameter->tBegin();
          return 0;
       }
 
@@ -213,36 +256,54 @@ namespace asc
       template <typename T>
       std::deque<T> history(const std::string &id)
       {
-         if (maps.count(typeid(T)))
-         {
-            auto& map = getMap<T>();
-
-            auto p = map.find(id);
-            if (p != map.end())
-               return p->second.history();
-            else
-               simulator.setError("Variable <" + id + "> could not be located.");
-         }
-         else
-            simulator.setError(static_cast<std::string>("No variables of type <") + typeid(T).name() + "> were set for access.");
+         Parameter<T>* parameter = find<T>(id);
+         if (parameter)
+            return parameter->history();
 
          return std::deque<T>();
       }
 
       void steps(const std::string& id, size_t steps)
       {
-         if (steps_map.count(id))
-            steps_map[id](steps);
-         else
-            simulator.setError("Access failure in Vars::setSteps(" + id + ", " + std::to_string(steps) + ")");
+         ParameterBase* parameter = findTrackable(id, "steps(const std::string& id, size_t steps)");
+         if (parameter)
+            parameter->steps = steps;
       }
 
       void steps(const std::string& id, bool infinite = true)
       {
-         if (steps_infinite_map.count(id))
-            steps_infinite_map[id](infinite);
-         else
-            simulator.setError("Access failure in Vars::setStepsInfinite(" + id + ", " + std::to_string(infinite) + ")");
+         ParameterBase* parameter = findTrackable(id, "steps(const std::string& id, bool infinite)");
+         if (parameter)
+            parameter->setInfinite(infinite);
+      }
+
+      void rate(const std::string& id, const Rate& rate)
+      {
+         ParameterBase* parameter = findTrackable(id, "rate(const std::string& id, const Rate& rate)");
+         if (parameter)
+            parameter->setRate(rate);
+      }
+
+      /** Save or restore every variable for a checkpoint (see Archive). Variables are matched by name, those that aren't defined (or are of another type) are skipped on restore. */
+      void serialize(Archive& archive)
+      {
+         const size_t n = archive.size(parameters.size());
+         for (size_t i = 0; i < n; ++i)
+         {
+            std::string type, id;
+            if (!archive.loading())
+            {
+               type = names[i].first;
+               id = names[i].second;
+            }
+            archive(type, id);
+
+            const size_t block = archive.begin();
+            auto p = indices.find(id);
+            if (p != indices.end() && parameters[p->second]->type() == type)
+               parameters[p->second]->serialize(archive);
+            archive.end(block);
+         }
       }
 
       auto& getNames() { return names; }
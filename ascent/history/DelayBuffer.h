@@ -0,0 +1,214 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// DelayBuffer provides delayed values x(t - tau) of a variable, for transport delays and delay differential equations.
+// The simulator records the variable once per full step, right after the first update() of the step, so that the value and (optionally) its derivative
+// are both those of the accepted step. Runge-Kutta stage values are predictions rather than points of the solution, so they aren't recorded,
+// instead lookups use cubic Hermite interpolation between the recorded steps (with the recorded derivatives when given), which is the dense output of the step.
+// Only the values within the maximum delay are kept, in ring buffers. Lookups advance an interpolation cursor, which is amortized O(1) when delays are constant.
+// Delays shorter than the current step extrapolate from the last recorded step.
+//
+// Discontinuities in a delayed value's derivatives (such as at the start of recording, where the solution meets its initial history) reappear in the
+// solution one delay later, and then again every delay. For every constant delay declared with lag(), the simulator selects steps that land on these times.
+
+#include "ascent/Module.h"
+#include "ascent/core/ModuleCore.h"
+
+#include "ascent/algorithms/Interpolation.h"
+#include "ascent/core/RingBuffer.h"
+#include "ascent/io/Archive.h"
+
+#include <algorithm>
+#include <functional>
+#include <set>
+
+namespace asc
+{
+   // Interface through which the simulator records and aligns steps to every DelayBuffer.
+   class DelayBase
+   {
+   public:
+      virtual ~DelayBase() {}
+
+      virtual void record() = 0; // record the current value (the first pass of a full step)
+      virtual void align() = 0; // limit the next full step to the next pending discontinuity
+   };
+
+   // Type T is a double or an Eigen::Vector.
+   template <typename T>
+   class DelayBuffer : public DelayBase
+   {
+   private:
+      Simulator& simulator;
+
+      const T* source;
+      const T* derivative; // nullptr if slopes are estimated from the recorded values
+
+      RingBuffer<double> th; // time history
+      RingBuffer<T> x; // value history
+      RingBuffer<T> xd; // derivative history, only if derivatives are recorded
+      Interpolation::Cursor<RingBuffer<double>, RingBuffer<T>> cursor{ th, x };
+
+      std::function<T(double)> initial; // the history before recording began, the first value is held if not set
+
+      double t_start = 0.0; // time at which recording began
+      std::set<double> lags; // constant delays whose discontinuities are propagated
+      std::set<double> pending; // discontinuity times that steps will land on
+      size_t levels = 4; // the number of times a discontinuity is propagated (the solution is smoother after every delay)
+
+      void propagate(const double t0)
+      {
+         for (const double tau : lags)
+         {
+            for (size_t k = 1; k <= levels; ++k)
+               pending.insert(t0 + k * tau);
+         }
+      }
+
+      void reserve() // the number of steps within the maximum delay, at the base time step
+      {
+         const size_t steps = (simulator.dtp > 0.0) ? static_cast<size_t>(max_delay / simulator.dtp) + 4 : 8;
+         th.reserve(steps);
+         x.reserve(steps);
+         if (derivative)
+            xd.reserve(steps);
+      }
+
+   public:
+      /** Delays of x up to max_delay. With the derivative xd (such as a state's derivative), interpolation uses the recorded derivatives. */
+      DelayBuffer(const size_t sim, const T& x, const double max_delay) : simulator(ModuleCore::getSimulator(sim)), source(&x), derivative(nullptr), max_delay(max_delay)
+      {
+         simulator.delays.push_back(this);
+      }
+
+      DelayBuffer(const size_t sim, const T& x, const T& xd, const double max_delay) : simulator(ModuleCore::getSimulator(sim)), source(&x), derivative(&xd), max_delay(max_delay)
+      {
+         simulator.delays.push_back(this);
+      }
+
+      ~DelayBuffer()
+      {
+         auto& delays = simulator.delays;
+         delays.erase(std::remove(delays.begin(), delays.end(), this), delays.end());
+      }
+
+      DelayBuffer(const DelayBuffer&) = delete; // the cursor refers to the buffers
+      DelayBuffer& operator = (const DelayBuffer&) = delete;
+
+      const double max_delay;
+
+      /** The history before recording began, as a function of time. */
+      void setHistory(const std::function<T(double)>& history) { initial = history; }
+
+      /** Declare a constant delay, so that steps land on the discontinuities it propagates. */
+      void lag(const double tau)
+      {
+         if (tau > max_delay)
+            simulator.setError("DelayBuffer lag of " + std::to_string(tau) + " exceeds the maximum delay of " + std::to_string(max_delay) + ".");
+
+         lags.insert(tau);
+         if (!th.empty())
+         {
+            for (size_t k = 1; k <= levels; ++k)
+               pending.insert(t_start + k * tau);
+         }
+      }
+
+      /** A discontinuity of the delayed variable at time t0 (e.g. from an event), which is propagated by every declared lag. */
+      void discontinuity(const double t0) { propagate(t0); }
+
+      void setLevels(const size_t n) { levels = n; } // how many delays later discontinuities are still aligned to (default 4)
+
+      /** The value at t - tau. */
+      T operator ()(const double tau) { return at(simulator.t - tau); }
+
+      /** The value at time t_target. */
+      T at(const double t_target)
+      {
+         if (th.empty() || t_target < th.front())
+         {
+            if (initial)
+               return initial(t_target);
+            return th.empty() ? *source : x.front();
+         }
+
+         const size_t n = th.size();
+         if (t_target >= th[n - 1]) // beyond the last recorded step
+         {
+            if (derivative)
+               return x[n - 1] + (t_target - th[n - 1]) * xd[n - 1];
+            else if (n > 1)
+               return x[n - 1] + (t_target - th[n - 1]) * ((x[n - 1] - x[n - 2]) / (th[n - 1] - th[n - 2]));
+            return x[n - 1];
+         }
+
+         if (derivative)
+            return cursor.hermite(t_target, xd);
+         return cursor.hermite(t_target);
+      }
+
+      void record()
+      {
+         const double t = simulator.t;
+         if (!th.empty() && t <= th.back())
+            return; // already recorded (e.g. when a run continues from the same time)
+
+         if (th.empty())
+         {
+            t_start = t;
+            reserve();
+            propagate(t); // the solution meets its initial history
+         }
+
+         th.push_back(t);
+         x.push_back(*source);
+         if (derivative)
+            xd.push_back(*derivative);
+
+         while (th.size() > 3 && th[2] <= t - max_delay) // keep the brackets (and their neighbors for slopes) of every time within the maximum delay
+         {
+            th.pop_front();
+            x.pop_front();
+            if (derivative)
+               xd.pop_front();
+         }
+      }
+
+      void align()
+      {
+         while (!pending.empty() && *pending.begin() <= simulator.t + simulator.EPS)
+            pending.erase(pending.begin());
+
+         if (!pending.empty())
+            simulator.event(*pending.begin());
+      }
+
+      size_t size() const { return th.size(); }
+      const RingBuffer<double>& time() const { return th; }
+      const RingBuffer<T>& history() const { return x; }
+
+      void clear()
+      {
+         th.clear();
+         x.clear();
+         xd.clear();
+         pending.clear();
+      }
+
+      /** Save or restore the recorded history, for a Module::serialize override (see Archive). */
+      void serialize(Archive& archive) { archive(th, x, xd, t_start, lags, pending, levels); }
+   };
+}
\ No newline at end of file
@@ -20,7 +20,10 @@
 #include "ascent/algorithms/Derivative.h"
 #include "ascent/algorithms/Extrapolation.h"
 #include "ascent/algorithms/Integral.h"
+#include "ascent/algorithms/RecursiveLeastSquares.h"
+#include "ascent/algorithms/RunningStatistics.h"
 #include "ascent/algorithms/Statistics.h"
+#include "ascent/core/RingBuffer.h"
 
 #include <memory>
 
@@ -35,14 +38,20 @@ namespace asc
       void insert(const double value);
 
    protected:
-      // using std::deque because erasing first element is far faster than std::vector
-      std::deque<double> th; // time history
-      std::deque<double> x; // parameter history
+      // using RingBuffer because erasing the first element is O(1) and doesn't allocate, while storage stays contiguous
+      RingBuffer<double> th; // time history
+      RingBuffer<double> x; // parameter history
+      RunningStatistics<double> statistics; // statistics of x, kept up to date as values are recorded and dropped
 
       Eigen::Vector3d parabolic(double x) const { return Eigen::Vector3d(1.0, x, x*x); }
 
+      struct Parabolic { Eigen::Vector3d operator()(const double x) const { return Eigen::Vector3d(1.0, x, x*x); } };
+      Integral::Running running_integral; // integral of x, kept up to date as values are recorded and dropped
+      RecursiveLeastSquares<Parabolic> parabolic_fit; // only kept up to date once extrapParabolicRecursive() has been called
+      bool fitting = false;
+
    public:
-      size_t steps; // The number of history steps to keep track of, derivatives only use the three most recent points at most.
+      size_t steps; // The number of history steps to keep track of, derivative() uses the three most recent points, a Derivative::Stencil uses its number of points.
       bool infinite; // Whether History should store data indefinitely.
 
       History(const size_t sim, const size_t steps);
@@ -59,19 +68,23 @@ namespace asc
       double& back() { return x.back(); }
       double& front() { return x.front(); }
 
-      void clear() { x.clear(); th.clear(); }
+      void clear() { x.clear(); th.clear(); statistics.clear(); running_integral.clear(); parabolic_fit.clear(); }
 
-      const std::deque<double>& history() const { return x; }
-      const std::deque<double>& time() const { return th; }
+      const RingBuffer<double>& history() const { return x; }
+      const RingBuffer<double>& time() const { return th; }
 
       // Algorithms:
       // CurveFit:
       template <typename Function>
-      Eigen::VectorXd fit2D(double& relative_error, Function func) const { Fit2D::fit2D(th, x, relative_error, func); }
+      Eigen::VectorXd fit2D(double& relative_error, Function func) const { return Fit2D::fit2D(th, x, relative_error, func); }
       
       // Derivative:
       double derivative() const { return Derivative::derivative(th, x); }
 
+      /** Derivative with a higher order or smoothing stencil, the stencil caches its weights between calls (see Derivative::Stencil). */
+      template <size_t points, size_t degree, size_t order>
+      double derivative(Derivative::Stencil<double, points, degree, order>& stencil) const { return stencil(th, x); }
+
       // Extrapolation:
       template <typename Function>
       double extrapolate(const double xest, double& relative_error, Function func) const { return Extrapolation::extrapolate(th, x, xest, relative_error, func); }
@@ -82,11 +95,24 @@ namespace asc
          return Extrapolation::extrapolate(th, x, xest, relative_error, func);
       }
 
-      // Integral:
-      double integral() const { return Integral::trapUnequal(th, x); }
+      /** The same fit as extrapParabolic, but updated in O(1) as values are pushed rather than solved from the whole history on every call (see RecursiveLeastSquares).
+      * A forgetting factor below one additionally weights values by forgetting^age. The fit is computed from the history on the first call and kept up to date from then on. */
+      double extrapParabolicRecursive(const double xest, double& relative_error, const double forgetting = 1.0);
+
+      // Integral (O(1), see Integral::Running):
+      double integral() const { return running_integral.value(th, x); }
+
+      void setIntegralRule(const Integral::Rule rule) // trapezoidal by default
+      {
+         running_integral = Integral::Running(rule);
+         running_integral.reset(th, x);
+      }
 
-      // Statistics:
-      double mean() const { return Statistics::mean(x); }
-      double stdDeviation() const { return Statistics::stdDeviation(x); }
+      // Statistics (O(1), see RunningStatistics):
+      double mean() const { return statistics.mean(); }
+      double variance() const { return statistics.variance(); }
+      double stdDeviation() const { return statistics.stdDeviation(); }
+      double min() const { return statistics.min(); }
+      double max() const { return statistics.max(); }
    };
 }
\ No newline at end of file
@@ -0,0 +1,230 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// HistoryPyramid is a sparse, long horizon time history. Recent samples are kept at full resolution and older samples in progressively coarser levels.
+// Each level holds up to level_size samples. When a level is full, its two oldest samples are merged into the next level (the older of the two is kept),
+// so every level covers twice the time of the level below it. A push is O(1) amortized, and memory only grows with the logarithm of the time covered
+// (level_size samples per level, 40 levels cover 2^40 * level_size steps).
+// The levels are viewed as a single sequence, oldest first, through times() and values(), which the history algorithms accept like any other container.
+
+#include "ascent/Module.h"
+#include "ascent/core/ModuleCore.h"
+
+#include "ascent/algorithms/Derivative.h"
+#include "ascent/core/RingBuffer.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace asc
+{
+   // Type T is a double or an Eigen::Vector
+   template <typename T>
+   class HistoryPyramid
+   {
+   private:
+      Simulator& simulator;
+
+      struct Level
+      {
+         RingBuffer<double> th; // time history
+         RingBuffer<T> x; // parameter history
+      };
+
+      std::vector<Level> pyramid; // the finest level (most recent samples) first
+      size_t n = 0; // samples in all levels
+
+      void insert(const double time, const T& value)
+      {
+         double t_carry = time;
+         T carry = value;
+         for (size_t level = 0;; ++level)
+         {
+            if (level == pyramid.size())
+            {
+               pyramid.emplace_back();
+               pyramid.back().th.reserve(level_size);
+               pyramid.back().x.reserve(level_size);
+            }
+
+            Level& current = pyramid[level];
+            if (current.x.size() < level_size)
+            {
+               current.th.push_back(t_carry);
+               current.x.push_back(carry);
+               ++n;
+               return;
+            }
+
+            // merge the two oldest samples into the next level
+            const double t_merged = current.th.front();
+            const T merged = current.x.front();
+            current.th.pop_front();
+            current.x.pop_front();
+            current.th.pop_front();
+            current.x.pop_front();
+            --n; // one of the two is dropped, the other moves up a level
+
+            current.th.push_back(t_carry);
+            current.x.push_back(carry);
+
+            t_carry = t_merged;
+            carry = merged;
+         }
+      }
+
+      std::pair<size_t, size_t> locate(size_t i) const // the level of the ith sample (oldest first), and its index within the level
+      {
+         for (size_t level = pyramid.size(); level-- > 0;)
+         {
+            const size_t size = pyramid[level].x.size();
+            if (i < size)
+               return std::make_pair(level, i);
+            i -= size;
+         }
+         return std::make_pair(size_t(0), i);
+      }
+
+      static double zero(const double*) { return 0.0; }
+      template <typename U> static U zero(const U*) { return U::Zero(); }
+
+      static double derive(const RingBuffer<double>& th, const RingBuffer<double>& x) { return Derivative::derivative(th, x); }
+      template <typename U> static U derive(const RingBuffer<double>& th, const RingBuffer<U>& x) { return Derivative::vecDerivative<U>(th, x); }
+
+   public:
+      // A level member of every level, viewed as a single sequence (oldest first).
+      template <typename V>
+      class View
+      {
+      private:
+         const HistoryPyramid* history;
+         RingBuffer<V> Level::* member;
+
+      public:
+         typedef V value_type;
+         typedef IndexIterator<const View, const V> const_iterator;
+
+         View(const HistoryPyramid* history, RingBuffer<V> Level::* member) : history(history), member(member) {}
+
+         size_t size() const { return history->n; }
+         bool empty() const { return history->n == 0; }
+
+         const V& operator [](const size_t i) const
+         {
+            const std::pair<size_t, size_t> location = history->locate(i);
+            return (history->pyramid[location.first].*member)[location.second];
+         }
+
+         const V& front() const { return (*this)[0]; }
+         const V& back() const { return (history->pyramid[0].*member).back(); }
+
+         const_iterator begin() const { return const_iterator(this, 0); }
+         const_iterator end() const { return const_iterator(this, size()); }
+      };
+
+      const size_t level_size; // samples per level
+
+      HistoryPyramid(const size_t sim, const size_t level_size) : simulator(ModuleCore::getSimulator(sim)), level_size(level_size), t(simulator.t), dt(simulator.dt)
+      {
+         if (level_size < 4)
+            simulator.setError("A HistoryPyramid needs at least four samples per level.");
+      }
+
+      void error(const std::string& description) { simulator.setError(description); }
+
+      void push_back(const T& value)
+      {
+         if (n > 0 && simulator.t <= pyramid[0].th.back())
+            simulator.setError("Attempted push_back on HistoryPyramid when the current time is less than or equal to the last time recorded.");
+
+         insert(simulator.t, value);
+      }
+
+      const double& t; // Simulator time
+      const double& dt; // Simulator time step
+
+      size_t size() const { return n; }
+      bool empty() const { return n == 0; }
+      size_t levels() const { return pyramid.size(); }
+
+      const T& back() const { return pyramid[0].x.back(); }
+      const T& front() const { return values().front(); }
+
+      void clear()
+      {
+         pyramid.clear();
+         n = 0;
+      }
+
+      View<double> times() const { return View<double>(this, &Level::th); }
+      View<T> values() const { return View<T>(this, &Level::x); }
+
+      const RingBuffer<double>& time(const size_t level) const { return pyramid[level].th; } // the samples of a single level, level 0 being the most recent at full resolution
+      const RingBuffer<T>& history(const size_t level) const { return pyramid[level].x; }
+
+      // Algorithms:
+      // Derivative (from the three most recent samples, which are always at full resolution):
+      T derivative() const
+      {
+         if (n == 0)
+            return zero(static_cast<const T*>(nullptr));
+         return derive(pyramid[0].th, pyramid[0].x);
+      }
+
+      // Integral (trapezoidal, over every level):
+      T integral() const
+      {
+         T I = zero(static_cast<const T*>(nullptr));
+         const double* t_prev = nullptr;
+         const T* x_prev = nullptr;
+
+         for (size_t level = pyramid.size(); level-- > 0;)
+         {
+            const Level& current = pyramid[level];
+            for (size_t i = 0; i < current.x.size(); ++i)
+            {
+               if (t_prev)
+                  I += (current.th[i] - *t_prev) * (current.x[i] + *x_prev) / 2.0;
+               t_prev = &current.th[i];
+               x_prev = &current.x[i];
+            }
+         }
+         return I;
+      }
+
+      // Interpolation (linear, over every level). Times outside of the history return the oldest or the newest value.
+      T interpolate(const double time) const
+      {
+         if (n == 0)
+            return zero(static_cast<const T*>(nullptr));
+
+         const View<double> th = times();
+         const size_t high = std::lower_bound(th.begin(), th.end(), time) - th.begin();
+
+         if (high == 0)
+            return front();
+         else if (high == n)
+            return back();
+
+         const View<T> x = values();
+         const double t0 = th[high - 1];
+         const double t1 = th[high];
+         const T& x0 = x[high - 1];
+         return x0 + (x[high] - x0) * ((time - t0) / (t1 - t0));
+      }
+   };
+}
\ No newline at end of file
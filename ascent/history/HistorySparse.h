@@ -14,56 +14,17 @@
 
 #pragma once
 
-// This call is intended to filter out old history data so that graphing functions can more quickly plot a significant time history of a variable.
+// This class is intended to filter out old history data so that graphing functions can more quickly plot a significant time history of a variable.
+// Recent history is kept at full resolution and older history is progressively thinned, sample_size samples per level (see HistoryPyramid).
 
-// THIS ALGORITHM HAS NOT BEEN OPTIMIZED FOR ERASING, BECAUSE IT USES std::deque, IMPROVE THIS IN THE FUTURE TO IMPROVE PERFORMANCE
-
-#include "History.h"
+#include "HistoryPyramid.h"
 
 namespace asc
 {
    template <size_t sample_size>
-   class HistorySparse : public History
+   class HistorySparse : public HistoryPyramid<double>
    {
-   private:
-      size_t index = 1; // second element
-      double spacing_ratio = 0.001;
-
    public:
-      HistorySparse(const size_t sim) : History(sim)
-      {
-         History::steps = sample_size;
-      }
-
-      void push_back(const double value)
-      {
-         size_t loop = 0;
-
-         while (x.size() >= sample_size)
-         {
-            // Ideally we would work backwards halfway and then forwards halfway, because often the latest step added is the one to be erased
-
-            double time_diff = abs(th[index] - th[index - 1]);
-
-            if (time_diff < dt() + spacing_ratio*dt()) // if the sampled values are distanced less than the end sampling distance (within some extra room), then we want to remove the sample
-            {
-               x.erase(x.begin() + index);
-               th.erase(th.begin() + index);
-            }
-
-            if (loop > 0)
-               spacing_ratio *= 2.0;
-
-            ++index;
-
-            if (index >= x.size())
-            {
-               index = 1; // reset the index
-               ++loop;
-            }
-         }
-
-         History::push_back(value);
-      }
+      HistorySparse(const size_t sim) : HistoryPyramid<double>(sim, sample_size) {}
    };
 }
\ No newline at end of file
@@ -20,7 +20,9 @@
 #include "ascent/Module.h"
 
 #include "ascent/algorithms/Derivative.h"
+#include "ascent/algorithms/RunningStatistics.h"
 #include "ascent/algorithms/StatisticsVector.h"
+#include "ascent/core/RingBuffer.h"
 
 namespace asc
 {
@@ -32,14 +34,19 @@ namespace asc
       Simulator& simulator;
 
    protected:
-      // using std::deque because erasing first element is far faster than std::vector
-      std::deque<double> th; // time history
-      std::deque<E> x; // parameter history
+      // using RingBuffer because erasing the first element is O(1) and doesn't allocate, while storage stays contiguous
+      RingBuffer<double> th; // time history
+      RingBuffer<E> x; // parameter history
+      RunningStatistics<E> statistics; // coefficient-wise statistics of x, kept up to date as values are recorded and dropped
 
    public:
-      size_t steps; // The number of history steps to keep track of, derivatives only use the three most recent points at most.
+      size_t steps; // The number of history steps to keep track of, derivative() uses the three most recent points, a Derivative::Stencil uses its number of points.
 
-      HistoryVector(const size_t sim, const size_t steps = 3) : simulator(Module::getSimulator(sim)), steps(steps), t(simulator.t), dt(simulator.dt) {}
+      HistoryVector(const size_t sim, const size_t steps = 3) : simulator(Module::getSimulator(sim)), steps(steps), t(simulator.t), dt(simulator.dt)
+      {
+         th.reserve(steps);
+         x.reserve(steps);
+      }
 
       void error(const std::string& description) { simulator.setError(description); }
 
@@ -47,10 +54,17 @@ namespace asc
       {
          if (steps > 0)
          {
+            th.reserve(steps); // allows number of steps to be lengthened during runtime
+            x.reserve(steps);
+
             if (x.size() >= steps) // allows number of steps to be lengthened or reduced during runtime
             {
-               th.erase(th.begin());
-               x.erase(x.begin());
+               statistics.pop(x.front());
+               th.pop_front();
+               x.pop_front();
+
+               if (statistics.drifted())
+                  statistics.reset(x);
             }
 
             if (th.size() > 0)
@@ -61,6 +75,7 @@ namespace asc
 
             th.push_back(simulator.t);
             x.push_back(value);
+            statistics.push(value);
          }
       }
 
@@ -71,10 +86,10 @@ namespace asc
       E& back() { return x.back(); }
       E& front() { return x.front(); }
 
-      void clear() { x.clear(); th.clear(); }
+      void clear() { x.clear(); th.clear(); statistics.clear(); }
 
-      const std::deque<E>& history() const { return x; }
-      const std::deque<double>& time() const { return th; }
+      const RingBuffer<E>& history() const { return x; }
+      const RingBuffer<double>& time() const { return th; }
       std::deque<double> time(const size_t steps) const
       {
          std::deque<double> deq(th.end() - steps, th.end());
@@ -104,11 +119,20 @@ namespace asc
       // Derivative:
       E derivative() const { return Derivative::vecDerivative<E>(th, x); }
 
-      // Statistics:
-      E mean() const { return StatisticsVector::mean(x); }
-      E mean(const size_t steps) const { return StatisticsVector::mean(x, steps); } // Returns mean for a given number of steps back in history.
+      /** Derivative with a higher order or smoothing stencil, the stencil caches its weights between calls (see Derivative::Stencil). */
+      template <size_t points, size_t degree, size_t order>
+      E derivative(Derivative::Stencil<E, points, degree, order>& stencil) const { return stencil(th, x); }
+
+      // Statistics, of the whole history in O(1) (see RunningStatistics) or of a given number of steps back in history:
+      E mean() const { return statistics.mean(); }
+      E mean(const size_t steps) const { return (steps >= x.size()) ? statistics.mean() : StatisticsVector::mean(x, steps); }
+
+      E variance() const { return statistics.variance(); }
+
+      E stdDeviation() const { return statistics.stdDeviation(); }
+      E stdDeviation(const size_t steps) const { return (steps >= x.size()) ? statistics.stdDeviation() : StatisticsVector::stdDeviation(x, steps); }
 
-      E stdDeviation() const { return StatisticsVector::stdDeviation(x); }
-      E stdDeviation(const size_t steps) const { return StatisticsVector::stdDeviation(x, steps); }
+      E min() const { return statistics.min(); }
+      E max() const { return statistics.max(); }
    };
 }
\ No newline at end of file
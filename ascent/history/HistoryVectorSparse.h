@@ -14,52 +14,16 @@
 
 #pragma once
 
-#include "HistoryVector.h"
+// Sparse history of Eigen Vectors, see HistorySparse.
+
+#include "HistoryPyramid.h"
 
 namespace asc
 {
    template <typename E, size_t sample_size>
-   class HistoryVectorSparse : public HistoryVector<E>
+   class HistoryVectorSparse : public HistoryPyramid<E>
    {
-   private:
-      size_t index = 1; // second element
-      double spacing_ratio = 0.001;
-
    public:
-      HistoryVectorSparse(const size_t sim) : HistoryVector<E>(sim)
-      {
-         HistoryVector<E>::steps = sample_size;
-      }
-
-      void push_back(const E& value)
-      {
-         size_t loop = 0;
-
-         while (x.size() >= sample_size)
-         {
-            // Ideally we would work backwards halfway and then forwards halfway, because often the latest step added is the one to be erased
-
-            double time_diff = abs(th[index] - th[index - 1]);
-
-            if (time_diff < dt + spacing_ratio*dt) // if the sampled values are distanced less than the end sampling distance (within some extra room), then we want to remove the sample
-            {
-               x.erase(x.begin() + index);
-               th.erase(th.begin() + index);
-            }
-
-            if (loop > 0)
-               spacing_ratio *= 2.0;
-
-            ++index;
-
-            if (index >= x.size())
-            {
-               index = 1; // reset the index
-               ++loop;
-            }
-         }
-
-         HistoryVector<E>::push_back(value);
-      }
+      HistoryVectorSparse(const size_t sim) : HistoryPyramid<E>(sim, sample_size) {}
    };
 }
\ No newline at end of file
@@ -32,6 +32,7 @@ namespace asc
       void updateClock();
       double optimalTimeStep();
       bool adaptive() { return true; }
+      void serialize(Archive& archive) { StateStepper::serialize(archive); archive(t0, xd0, xd1, xd2, xd3, xd4, xd5, xd6, xd7, xd8, xd9, xd10, xd11); }
 
       double t0;
       double xd0, xd1, xd2, xd3, xd4, xd5, xd6, xd7, xd8, xd9, xd10, xd11;
@@ -35,6 +35,7 @@ namespace asc
 
       void propagate();
       void updateClock();
+      void serialize(Archive& archive) { StateStepper::serialize(archive); initializer->serialize(archive); archive(xd0, xd_1); }
 
       std::unique_ptr<RK4> initializer;
       double xd0;
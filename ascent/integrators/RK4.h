@@ -30,6 +30,7 @@ namespace asc
 
       void propagate();
       void updateClock();
+      void serialize(Archive& archive) { StateStepper::serialize(archive); archive(xd0, xd1, xd2, xd3); }
 
       double xd0, xd1, xd2, xd3;
    };
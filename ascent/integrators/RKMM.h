@@ -30,6 +30,7 @@ namespace asc
 
       void propagate();
       void updateClock();
+      void serialize(Archive& archive) { StateStepper::serialize(archive); archive(k1, k2, k3, k4, k5); }
 
       double  k1, k2, k3, k4, k5;
    };
@@ -33,6 +33,7 @@ namespace asc
 
       void propagate();
       void updateClock();
+      void serialize(Archive& archive) { StateStepper::serialize(archive); initializer->serialize(archive); archive(xd_1); }
 
       std::unique_ptr<RK4> initializer;
       double xd_1; // -1, previous time step derivative
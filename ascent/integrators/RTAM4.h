@@ -35,6 +35,8 @@ namespace asc
 
       void propagate();
       void updateClock();
+      void serialize(Archive& archive) { StateStepper::serialize(archive); initializer->serialize(archive); archive(init_step, xd0, xd_1, xd_2, xd_3); }
+      void serializeClock(Archive& archive) { archive(init_step); }
 
       std::unique_ptr<RK4> initializer;
       unsigned init_step = 0; // initialization step counter
@@ -0,0 +1,281 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// Archive is the binary format of simulator checkpoints (see Module::checkpoint and Module::restore).
+// The same serialize(Archive&) function both saves and restores an object: archive(a, b, c) appends the values when saving, and reads them back into the same variables when restoring.
+// Values are stored in native byte order, so a checkpoint is meant to be restored by the same build of a program.
+// Blocks (begin() and end()) are length prefixed, so that a restore can skip data it doesn't recognize.
+// A sharing archive (used to fork a simulator in memory, see Module::fork) doesn't copy histories into its data, they're shared copy on write with every restore.
+
+#include "ascent/core/Chunked.h"
+#include "ascent/core/RingBuffer.h"
+
+#include <Eigen/Dense>
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace asc
+{
+   class Archive;
+
+   // How a type is archived. Types without a specialization aren't archived, so on restore they keep the values they were constructed with.
+   template <typename T, typename Enable = void>
+   struct Archived
+   {
+      static const bool supported = false;
+      static void serialize(Archive&, T&) {}
+   };
+
+   class Archive
+   {
+   private:
+      std::string buffer;
+      size_t pos = 0; // read position when restoring
+      bool restoring = false;
+
+   public:
+      Archive() {} // an empty archive to save into
+      explicit Archive(std::string data) : buffer(std::move(data)), restoring(true) {} // an archive to restore from
+
+      bool loading() const { return restoring; } // true when restoring
+
+      bool sharing = false; // set before saving to share histories rather than copying them into the data
+      std::vector<std::shared_ptr<void>> shared; // the shared histories, in the order they were saved
+
+      /** An archive that restores what this archive saved, any number of restorers can be made from one archive. */
+      Archive restorer() const
+      {
+         Archive archive(buffer);
+         archive.sharing = sharing;
+         archive.shared = shared;
+         return archive;
+      }
+
+      /** When saving, keep a copy of value (whose copies should share storage) and archive its index. When restoring, assign that copy to value. */
+      template <typename T>
+      void share(T& value)
+      {
+         if (!restoring)
+            shared.push_back(std::make_shared<T>(value));
+
+         const size_t index = size(shared.size() - 1);
+         if (restoring)
+         {
+            if (index >= shared.size())
+               throw std::runtime_error("Archive: a shared value is missing.");
+            value = *std::static_pointer_cast<T>(shared[index]);
+         }
+      }
+
+      const std::string& data() const { return buffer; }
+
+      /** Append n bytes when saving, or read n bytes into data when restoring. Throws std::runtime_error if a restore reads past the end of the archive. */
+      void bytes(void* data, const size_t n);
+
+      /** Archive a length, returns n when saving and the stored length when restoring. */
+      size_t size(const size_t n);
+
+      /** Begin a length prefixed block, the returned mark is passed to end(). */
+      size_t begin();
+
+      /** End a block. When restoring, the part of the block that wasn't read is skipped. */
+      void end(const size_t mark);
+
+      template <typename T, typename... Trest>
+      void operator ()(T& value, Trest&... rest)
+      {
+         Archived<T>::serialize(*this, value);
+         (*this)(rest...);
+      }
+
+      void operator ()() {}
+   };
+
+   // Numbers, booleans, and enumerations are stored as raw bytes.
+   template <typename T>
+   struct Archived<T, typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value>::type>
+   {
+      static const bool supported = true;
+      static void serialize(Archive& archive, T& value) { archive.bytes(&value, sizeof(T)); }
+   };
+
+   template <>
+   struct Archived<std::string>
+   {
+      static const bool supported = true;
+      static void serialize(Archive& archive, std::string& value)
+      {
+         const size_t n = archive.size(value.size());
+         if (archive.loading())
+            value.resize(n);
+         if (n > 0)
+            archive.bytes(&value[0], n);
+      }
+   };
+
+   template <typename T>
+   struct Archived<std::vector<T>, typename std::enable_if<Archived<T>::supported && !std::is_same<T, bool>::value>::type>
+   {
+      static const bool supported = true;
+      static void serialize(Archive& archive, std::vector<T>& value)
+      {
+         const size_t n = archive.size(value.size());
+         if (archive.loading())
+            value.resize(n);
+
+         if (std::is_arithmetic<T>::value)
+         {
+            if (n > 0)
+               archive.bytes(value.data(), n * sizeof(T)); // contiguous numbers are archived in one piece
+         }
+         else
+         {
+            for (T& x : value)
+               Archived<T>::serialize(archive, x);
+         }
+      }
+   };
+
+   template <typename T>
+   struct Archived<std::deque<T>, typename std::enable_if<Archived<T>::supported>::type>
+   {
+      static const bool supported = true;
+      static void serialize(Archive& archive, std::deque<T>& value)
+      {
+         const size_t n = archive.size(value.size());
+         if (archive.loading())
+            value.resize(n);
+         for (T& x : value)
+            Archived<T>::serialize(archive, x);
+      }
+   };
+
+   template <typename T>
+   struct Archived<std::set<T>, typename std::enable_if<Archived<T>::supported>::type>
+   {
+      static const bool supported = true;
+      static void serialize(Archive& archive, std::set<T>& value)
+      {
+         const size_t n = archive.size(value.size());
+         if (archive.loading())
+         {
+            value.clear();
+            for (size_t i = 0; i < n; ++i)
+            {
+               T x;
+               Archived<T>::serialize(archive, x);
+               value.insert(x);
+            }
+         }
+         else
+         {
+            for (T x : value)
+               Archived<T>::serialize(archive, x);
+         }
+      }
+   };
+
+   // Eigen vectors and matrices of numbers, dynamic sizes are resized when restoring.
+   template <typename T>
+   struct Archived<T, typename std::enable_if<std::is_base_of<Eigen::PlainObjectBase<T>, T>::value && std::is_arithmetic<typename T::Scalar>::value>::type>
+   {
+      static const bool supported = true;
+      static void serialize(Archive& archive, T& value)
+      {
+         const size_t rows = archive.size(value.rows());
+         const size_t cols = archive.size(value.cols());
+         if (archive.loading() && (rows != static_cast<size_t>(value.rows()) || cols != static_cast<size_t>(value.cols())))
+         {
+            if (T::SizeAtCompileTime != Eigen::Dynamic)
+               throw std::runtime_error("Archive: a fixed size matrix was archived with a different size.");
+            value.resize(rows, cols);
+         }
+
+         if (rows * cols > 0)
+            archive.bytes(value.data(), rows * cols * sizeof(typename T::Scalar));
+      }
+   };
+
+   template <typename T>
+   struct Archived<RingBuffer<T>, typename std::enable_if<Archived<T>::supported>::type>
+   {
+      static const bool supported = true;
+      static void serialize(Archive& archive, RingBuffer<T>& value)
+      {
+         const size_t n = archive.size(value.size());
+         if (archive.loading())
+         {
+            value.clear();
+            value.reserve(n);
+            for (size_t i = 0; i < n; ++i)
+            {
+               T x;
+               Archived<T>::serialize(archive, x);
+               value.push_back(x);
+            }
+         }
+         else
+         {
+            for (T& x : value)
+               Archived<T>::serialize(archive, x);
+         }
+      }
+   };
+
+   // Compressed chunks are archived decompressed, and compressed again as they're restored.
+   template <typename T>
+   struct Archived<Chunked<T>, typename std::enable_if<Archived<T>::supported>::type>
+   {
+      static const bool supported = true;
+      static void serialize(Archive& archive, Chunked<T>& value)
+      {
+         if (archive.sharing)
+         {
+            archive.share(value); // filled chunks are shared rather than copied
+            return;
+         }
+
+         const size_t n = archive.size(value.size());
+         if (archive.loading())
+         {
+            value.clear();
+            value.reserve(n);
+            for (size_t i = 0; i < n; ++i)
+            {
+               T x;
+               Archived<T>::serialize(archive, x);
+               value.push_back(x);
+            }
+         }
+         else
+         {
+            const size_t chunks = value.chunkCount();
+            for (size_t c = 0; c < chunks; ++c)
+            {
+               for (T x : value.chunk(c))
+                  Archived<T>::serialize(archive, x);
+            }
+         }
+      }
+   };
+}
\ No newline at end of file
@@ -0,0 +1,173 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// BinaryTrack is a self describing, columnar binary format for tracked data (.ascb files), an alternative to CSV output that requires no formatting.
+//
+// Layout (native byte order, which is little endian on all supported platforms):
+//    char[8]  magic "ASCTRACK"
+//    uint32   version
+//    uint32   number of columns
+//    for each column:
+//       uint32   name length, followed by the name characters
+//       uint8    scalar type (see Scalar)
+//       uint8    flags (see Flags)
+//       uint32   rows, uint32 cols (Eigen shape, 1 x 1 for scalars)
+//       uint64   length (number of recorded values)
+//       uint64   offset of the column block from the start of the file
+//    column blocks, each aligned to 8 bytes: length * rows * cols scalars, each value stored in Eigen's (column major) order
+//
+// Column blocks are aligned and contiguous, so a memory mapped file can be read in place.
+
+#include "ascent/core/RingBuffer.h"
+
+#include <Eigen/Dense>
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace asc
+{
+   namespace BinaryTrack
+   {
+      enum class Scalar : uint8_t
+      {
+         float64,
+         float32,
+         int32,
+         uint64,
+         boolean
+      };
+
+      enum Flags : uint8_t
+      {
+         time_column = 1 // column holds the simulation time
+      };
+
+      size_t scalarSize(const Scalar scalar);
+
+      struct Layout
+      {
+         Layout() {}
+         Layout(const Scalar scalar, const uint32_t rows = 1, const uint32_t cols = 1) : supported(true), scalar(scalar), rows(rows), cols(cols) {}
+
+         bool supported = false;
+         Scalar scalar = Scalar::float64;
+         uint32_t rows = 1, cols = 1;
+
+         size_t elements() const { return static_cast<size_t>(rows) * cols; }
+         size_t bytes() const { return elements() * scalarSize(scalar); } // bytes per value
+      };
+
+      // The binary layout of a type, types without a specialization can't be written in binary.
+      template <typename T, typename Enable = void>
+      struct Type
+      {
+         static Layout layout() { return Layout(); }
+      };
+
+      template <> struct Type<double> { static Layout layout() { return Layout(Scalar::float64); } };
+      template <> struct Type<float> { static Layout layout() { return Layout(Scalar::float32); } };
+      template <> struct Type<int> { static Layout layout() { return Layout(Scalar::int32); } };
+      template <> struct Type<bool> { static Layout layout() { return Layout(Scalar::boolean); } };
+      template <> struct Type<uint64_t> { static Layout layout() { return Layout(Scalar::uint64); } };
+
+      // Fixed size Eigen vectors and matrices of doubles.
+      template <typename T>
+      struct Type<T, typename std::enable_if<std::is_base_of<Eigen::EigenBase<T>, T>::value && std::is_same<typename T::Scalar, double>::value
+         && (T::RowsAtCompileTime > 0) && (T::ColsAtCompileTime > 0)>::type>
+      {
+         static Layout layout() { return Layout(Scalar::float64, T::RowsAtCompileTime, T::ColsAtCompileTime); }
+      };
+
+      template <typename T>
+      bool supported() { return Type<T>::layout().supported && sizeof(T) == Type<T>::layout().bytes(); }
+
+      /** Write contiguous values as raw scalars. Does nothing for types that aren't supported (check supported<T>() first). */
+      template <typename T>
+      void write(std::ostream& stream, const Span<const T>& span)
+      {
+         if (supported<T>() && !span.empty())
+            stream.write(reinterpret_cast<const char*>(span.data()), span.size() * sizeof(T));
+      }
+
+      // A column to be written, the data is streamed by the write function.
+      struct Source
+      {
+         std::string name;
+         Layout layout;
+         uint8_t flags = 0;
+         uint64_t length = 0;
+         std::function<void(std::ostream&)> write; // must write exactly length * layout.bytes() bytes
+      };
+
+      void write(std::ostream& stream, const std::vector<Source>& sources);
+
+      /** Append a single value (stored as raw scalars) to out, formatted the same way as ToString::print (see Format), elements are comma separated. */
+      void print(std::string& out, const Layout& layout, const char* value);
+      void printJson(std::string& out, const Layout& layout, const char* value); // as print, but with Format::appendJson (non-finite numbers are null)
+
+      // Reads a BinaryTrack file, memory mapping it where possible. Throws std::runtime_error if the file can't be read.
+      class File
+      {
+      public:
+         struct Column
+         {
+            std::string name;
+            Layout layout;
+            uint8_t flags = 0;
+            uint64_t length = 0;
+            const char* data = nullptr;
+
+            /** Element of the ith value, converted to double. */
+            double value(const size_t i, const size_t element = 0) const;
+
+            /** Typed access to the column's scalars, nullptr if T doesn't match the stored scalar type. */
+            template <typename T>
+            const T* scalars() const
+            {
+               if (Type<T>::layout().scalar == layout.scalar && Type<T>::layout().supported)
+                  return reinterpret_cast<const T*>(data);
+               return nullptr;
+            }
+         };
+
+         File(const std::string& filename);
+         ~File();
+
+         File(const File&) = delete;
+         File& operator = (const File&) = delete;
+
+         std::vector<Column> columns;
+
+         const Column* find(const std::string& name) const; // nullptr if not found
+
+         void toCSV(std::ostream& stream) const; // same layout as Module::outputTrack CSV files
+         void toJSON(std::ostream& stream) const; // an object with an array of values per column
+
+      private:
+         const char* begin = nullptr;
+         size_t size = 0;
+         std::vector<char> buffer; // file contents when memory mapping isn't available
+         void* mapping = nullptr;
+
+         void parse();
+      };
+   }
+}
\ No newline at end of file
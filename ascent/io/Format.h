@@ -0,0 +1,197 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+// Format writes values as text for output files, quickly and without losing precision.
+// Floating point numbers are written with the fewest digits that read back as exactly the same number (Grisu2, Loitsch 2010),
+// independent of the locale and without printf, so "0.1" is written as 0.1 and no digits are lost as with std::to_string's six decimal places.
+// Values are appended to a caller owned std::string, which can be reused (cleared) between rows to avoid allocation.
+
+#include <Eigen/Dense>
+
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace asc
+{
+   namespace Format
+   {
+      // Whether append supports T: arithmetic types, std::string, Eigen types, and vectors and deques of supported types.
+      template <typename T>
+      struct Formattable : std::integral_constant<bool, std::is_arithmetic<T>::value || std::is_same<T, std::string>::value || std::is_base_of<Eigen::EigenBase<T>, T>::value> {};
+
+      template <typename T>
+      struct Formattable<std::vector<T>> : Formattable<T> {};
+
+      template <typename T>
+      struct Formattable<std::deque<T>> : Formattable<T> {};
+
+      static const size_t buffer_size = 32; // enough for any number written by write()
+
+      char* write(char* first, const double x); // writes x starting at first, returns the end of the written characters
+      char* write(char* first, const float x);
+      char* write(char* first, const int64_t x);
+      char* write(char* first, const uint64_t x);
+
+      inline void append(std::string& out, const double x)
+      {
+         char buffer[buffer_size];
+         out.append(buffer, write(buffer, x));
+      }
+
+      inline void append(std::string& out, const float x)
+      {
+         char buffer[buffer_size];
+         out.append(buffer, write(buffer, x));
+      }
+
+      inline void append(std::string& out, const bool x) { out += x ? '1' : '0'; }
+
+      template <typename T>
+      inline typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value && std::is_signed<T>::value>::type append(std::string& out, const T x)
+      {
+         char buffer[buffer_size];
+         out.append(buffer, write(buffer, static_cast<int64_t>(x)));
+      }
+
+      template <typename T>
+      inline typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value && std::is_unsigned<T>::value>::type append(std::string& out, const T x)
+      {
+         char buffer[buffer_size];
+         out.append(buffer, write(buffer, static_cast<uint64_t>(x)));
+      }
+
+      inline void append(std::string& out, const std::string& x) { out += x; }
+
+      // Elements of vectors, deques and Eigen types are comma separated (Eigen types in column major order).
+
+      template <typename T>
+      inline void append(std::string& out, const std::vector<T>& x);
+
+      template <typename T>
+      inline void append(std::string& out, const std::deque<T>& x);
+
+      template <typename Derived>
+      inline void append(std::string& out, const Eigen::DenseBase<Derived>& x)
+      {
+         const Eigen::Index n = x.size();
+         for (Eigen::Index i = 0; i < n; ++i)
+         {
+            append(out, static_cast<typename Derived::Scalar>(x.derived().array()(i)));
+            if (i < n - 1) // not the last element
+               out += ',';
+         }
+      }
+
+      template <typename Container>
+      inline void appendElements(std::string& out, const Container& x)
+      {
+         const size_t n = x.size();
+         for (size_t i = 0; i < n; ++i)
+         {
+            append(out, static_cast<typename Container::value_type>(x[i]));
+            if (i < n - 1) // not the last element
+               out += ',';
+         }
+      }
+
+      template <typename T>
+      inline void append(std::string& out, const std::vector<T>& x) { appendElements(out, x); }
+
+      template <typename T>
+      inline void append(std::string& out, const std::deque<T>& x) { appendElements(out, x); }
+
+      // JSON values: numbers that aren't finite are written as null, booleans as true or false, strings are quoted,
+      // and vectors, deques and Eigen types are arrays (Eigen types in column major order).
+
+      void appendJson(std::string& out, const std::string& x); // quoted and escaped
+
+      inline void appendJson(std::string& out, const char* x) { appendJson(out, std::string(x)); }
+
+      inline void appendJson(std::string& out, const double x)
+      {
+         if (std::isfinite(x))
+            append(out, x);
+         else
+            out += "null";
+      }
+
+      inline void appendJson(std::string& out, const float x)
+      {
+         if (std::isfinite(x))
+            append(out, x);
+         else
+            out += "null";
+      }
+
+      inline void appendJson(std::string& out, const bool x) { out += x ? "true" : "false"; }
+
+      template <typename T>
+      inline typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type appendJson(std::string& out, const T x) { append(out, x); }
+
+      template <typename T>
+      inline void appendJson(std::string& out, const std::vector<T>& x);
+
+      template <typename T>
+      inline void appendJson(std::string& out, const std::deque<T>& x);
+
+      template <typename Derived>
+      inline void appendJson(std::string& out, const Eigen::DenseBase<Derived>& x)
+      {
+         out += '[';
+         const Eigen::Index n = x.size();
+         for (Eigen::Index i = 0; i < n; ++i)
+         {
+            appendJson(out, static_cast<typename Derived::Scalar>(x.derived().array()(i)));
+            if (i < n - 1) // not the last element
+               out += ',';
+         }
+         out += ']';
+      }
+
+      template <typename Container>
+      inline void appendJsonElements(std::string& out, const Container& x)
+      {
+         out += '[';
+         const size_t n = x.size();
+         for (size_t i = 0; i < n; ++i)
+         {
+            appendJson(out, static_cast<typename Container::value_type>(x[i]));
+            if (i < n - 1) // not the last element
+               out += ',';
+         }
+         out += ']';
+      }
+
+      template <typename T>
+      inline void appendJson(std::string& out, const std::vector<T>& x) { appendJsonElements(out, x); }
+
+      template <typename T>
+      inline void appendJson(std::string& out, const std::deque<T>& x) { appendJsonElements(out, x); }
+
+      template <typename T>
+      inline std::string toString(const T& x)
+      {
+         std::string out;
+         append(out, x);
+         return out;
+      }
+   }
+}
\ No newline at end of file
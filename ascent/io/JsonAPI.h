@@ -16,14 +16,22 @@
 
 // JsonAPI allows module data access, assignment, and chaiscript calls via JSON script.
 // The idea in input/output of variables is for the output to be used as input (and vice versa) so that Ascent simulations can directly assign data once accessed.
+// Current values of variables in the simulator's Snapshot (see Module::snapshot) are read from the snapshot, so they're step coherent even while the simulation runs.
+//
+// A variable's history over a time range is requested with "t0" and/or "t1" (either may be omitted for an open range), e.g. {"var": "x", "type": "d", "t0": 0.0, "t1": 10.0, "max_points": 2000}.
+// The output holds "t" and "value" arrays. With "max_points" the history is decimated by the server, "decimation" chooses the method:
+// "lttb" (largest triangle three buckets, the default), "minmax" (the extremes of each bucket) or "stride" (every kth sample). Non-numeric types always use "stride".
 
 #define JSONCONS_NO_DEPRECATED // Don't allow deprecated function use.
 #pragma warning(disable: 4996) // need to disable error for fopen used in json.hpp
 #include "jsoncons/json.hpp"
 
 #include "ascent/Link.h"
+#include "ascent/algorithms/Decimation.h"
 #include "ascent/algorithms/Interpolation.h"
 
+#include <limits>
+
 namespace asc
 {
    class JsonAPI
@@ -39,19 +47,72 @@ namespace asc
       static jsoncons::json ioFile(const std::string& filename); // filename should end with .json
 
    private:
-      template <typename T, typename std::enable_if<std::is_floating_point<T>::value>::type>
-      static double interpolate(const double x_target, const std::vector<T>& x, const std::deque<T>& y)
+      template <typename T>
+      static T interpolate(const double x_target, const TimeView<T>& x, const HistoryView<T>& y)
       {
-         return Interpolation::linear(x_target, x, y);
+         return Interpolation::closestNeighbor(x_target, x, y);
       }
 
       template <typename T>
-      static T interpolate(const double x_target, const std::vector<double>& x, const std::deque<T>& y)
+      static typename std::enable_if<std::is_arithmetic<T>::value, std::vector<size_t>>::type decimate(const Parameter<T>& parameter, const size_t begin, const size_t end, const size_t max_points, const std::string& method)
       {
-         return Interpolation::closestNeighbor(x_target, x, y);
+         auto x = [&](const size_t i) { return parameter.time(i); };
+         auto y = [&](const size_t i) { return static_cast<double>(parameter.value(i)); };
+
+         if (method == "minmax")
+            return Decimation::minMax(y, begin, end, max_points);
+         if (method == "stride")
+            return Decimation::stride(begin, end, max_points);
+         return Decimation::lttb(x, y, begin, end, max_points);
       }
 
-      static std::string interpolate(const double x_target, const std::vector<double>& x, const std::vector<std::string>& y) { return y.back(); }
+      template <typename T>
+      static typename std::enable_if<!std::is_arithmetic<T>::value, std::vector<size_t>>::type decimate(const Parameter<T>& parameter, const size_t begin, const size_t end, const size_t max_points, const std::string& method)
+      {
+         return Decimation::stride(begin, end, max_points);
+      }
+
+      // The history between the times t0 and t1 (inclusive), read in place and decimated to at most max_points samples.
+      template <typename T>
+      static void range(jsoncons::json& obj, jsoncons::json& obj_out, const Parameter<T>& parameter)
+      {
+         const double t0 = obj.count("t0") ? obj["t0"].as<double>() : -std::numeric_limits<double>::infinity();
+         const double t1 = obj.count("t1") ? obj["t1"].as<double>() : std::numeric_limits<double>::infinity();
+
+         const size_t begin = parameter.lowerBound(t0);
+         const size_t end = std::max(begin, parameter.upperBound(t1));
+
+         size_t max_points = obj.count("max_points") ? obj["max_points"].as<size_t>() : 0;
+         if (max_points == 0) // no decimation
+            max_points = end - begin;
+
+         const std::string method = obj.count("decimation") ? obj["decimation"].as<std::string>() : "lttb";
+
+         jsoncons::json times = jsoncons::json::array();
+         jsoncons::json values = jsoncons::json::array();
+         for (const size_t i : decimate(parameter, begin, end, max_points, method))
+         {
+            times.add(parameter.time(i));
+            values.add(parameter.value(i));
+         }
+
+         obj_out["t"] = std::move(times);
+         obj_out["value"] = std::move(values);
+      }
+
+      // The current value, from the simulator's Snapshot if the variable is part of it, so that reads from other threads don't race with a running simulation.
+      template <typename T>
+      static T current(Module& base, const Var<T>& handle)
+      {
+         Snapshot::View view = base.simulator.snapshot.read();
+         if (view)
+         {
+            const T* x = view.get<T>(&*handle);
+            if (x)
+               return *x;
+         }
+         return handle.get();
+      }
 
       template <typename T>
       static bool access(jsoncons::json& obj, jsoncons::json& obj_out, Module& base)
@@ -62,19 +123,21 @@ namespace asc
          bool success = false;
          if (typeid(T).name() == type)
          {
-            success = true;
-            if (obj.count("value")) // If a "value" member is specified, then we assume the user wants to set the variable.
-               success = base.vars.set(var, obj["value"].as<T>());
+            Var<T> handle = base.vars.handle<T>(var); // a single lookup for all of the following access
+            success = handle.valid();
+            if (success && obj.count("value")) // If a "value" member is specified, then we assume the user wants to set the variable.
+               handle.set(obj["value"].as<T>());
 
-            if (obj.count("t"))
+            obj_out["type"] = type;
+            if (success && (obj.count("t0") || obj.count("t1")))
+               range(obj, obj_out, handle.param());
+            else if (success && obj.count("t"))
             {
                const double t = obj["t"].as<double>();
-               const auto& hist = base.history<T>(var);
-               obj_out["value"] = interpolate(t, base.timeHistory(), hist);
+               obj_out["value"] = interpolate(t, handle.time(), handle.history()); // each variable's own times, which differ from t_hist when it began recording late or is decimated
             }
-
-            obj_out["type"] = type;
-            obj_out["value"] = base.vars.get<T>(var);
+            else if (success)
+               obj_out["value"] = current(base, handle);
             obj_out["var"] = var;
          }
 
@@ -0,0 +1,73 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+// JsonWriter emits JSON text as it's generated, without building a document in memory.
+// Output is either appended to a std::string or buffered and written to a std::ostream in large pieces.
+// Separators are handled by the writer, values are formatted with Format (see Format::appendJson).
+
+#include "ascent/io/Format.h"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace asc
+{
+   // Layout of tracked data written as JSON, see Module::jsonTrack.
+   enum class JsonLayout
+   {
+      rows, // an array of rows, the first row holds the column names: [["t","a x"],[0,1.5],...]
+      columns // an object with an array of values per column: {"t":[0,...],"a x":[1.5,...]}
+   };
+
+   class JsonWriter
+   {
+   public:
+      JsonWriter(std::string& out); // appends to out
+      JsonWriter(std::ostream& stream, const size_t buffer_size = 1 << 16); // writes to stream whenever buffer_size bytes are pending
+      ~JsonWriter(); // writes anything pending
+
+      JsonWriter(const JsonWriter&) = delete;
+      JsonWriter& operator = (const JsonWriter&) = delete;
+
+      void beginObject();
+      void endObject();
+      void beginArray();
+      void endArray();
+
+      void key(const std::string& name); // the next value is the member called name
+
+      /** Begin a value and return the output to append it to, which must be exactly one JSON value. */
+      std::string& value();
+
+      template <typename T>
+      void value(const T& x) { Format::appendJson(value(), x); }
+
+      void flush(); // write pending output to the stream
+
+   private:
+      std::string buffer; // pending output when writing to a stream
+      std::string& out;
+      std::ostream* stream = nullptr;
+      size_t buffer_size = 0;
+
+      std::vector<bool> first; // for each open object or array, whether nothing has been written to it yet
+      bool after_key = false;
+
+      void separate();
+   };
+}
\ No newline at end of file
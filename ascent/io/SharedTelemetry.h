@@ -0,0 +1,134 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+// SharedTelemetry publishes tracked variables to a POSIX shared memory ring of frames (one frame per full step), which any number of processes can read without blocking the simulation.
+// The Writer is used by Module::shareTelemetry, the Reader is a small library for external processes (it only depends on this header and SharedTelemetry.cpp).
+//
+// Layout of the shared memory object (native byte order):
+//    Header (see below), followed by a ColumnInfo per column, followed by capacity slots.
+//    Each slot is a uint64 sequence followed by the frame: the time t, then the values of all columns as doubles (elements of Eigen types in column major order).
+//
+// Slots are versioned: while frame n is written to slot n % capacity its sequence is 2n + 1, and 2n + 2 once complete.
+// A reader copies a frame between two reads of the sequence, and keeps the copy only if both equal 2n + 2, so torn or overwritten frames are detected rather than returned.
+// All shared words are accessed as lock-free std::atomic<uint64_t>, which is address free, so the protocol holds across processes.
+
+#include "ascent/io/BinaryTrack.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace asc
+{
+   namespace SharedTelemetry
+   {
+      static const uint32_t version = 1;
+      static const size_t name_size = 64; // maximum column name length, including the terminating null
+
+      struct Header
+      {
+         char magic[8]; // "ASCTELEM", written last so readers never see a partial header
+         uint32_t version;
+         uint32_t columns;
+         uint32_t frame_words; // words (doubles) per frame, including t
+         uint32_t capacity; // number of slots
+         std::atomic<uint64_t> frames; // number of frames published
+      };
+
+      struct ColumnInfo
+      {
+         char name[name_size];
+         uint32_t offset; // index of the column's first value in a frame (t is index 0)
+         uint32_t elements; // values per row, rows * cols for Eigen types
+      };
+
+      struct Frame
+      {
+         uint64_t index = 0; // frame number, counting from zero
+         double t = 0.0;
+         std::vector<double> values; // all columns, see ColumnInfo::offset (minus one for t)
+      };
+
+      // Publishes frames, used by the simulation thread.
+      class Writer
+      {
+      public:
+         struct Column
+         {
+            std::string name;
+            BinaryTrack::Layout layout; // must be supported, values are converted to double
+         };
+
+         Writer() {}
+         ~Writer(); // unmaps and removes the shared memory object, readers that already mapped it keep their mapping
+
+         Writer(const Writer&) = delete;
+         Writer& operator = (const Writer&) = delete;
+
+         /** Create (or replace) the shared memory object called name, e.g. "/sim_telemetry". Returns false on failure (always on Windows).
+         * Throws std::runtime_error if a column name doesn't fit in name_size. */
+         bool open(const std::string& name, const std::vector<Column>& columns, const size_t capacity);
+         void close();
+
+         bool isOpen() const { return header != nullptr; }
+
+         /** Publish a frame. values are the raw current values of each column, laid out as given to open(). */
+         void write(const double t, const std::vector<const void*>& values);
+
+      private:
+         std::string name;
+         Header* header = nullptr;
+         size_t bytes = 0;
+         std::vector<Column> columns;
+         uint64_t frames = 0;
+      };
+
+      // Reads frames published by a Writer in another (or the same) process, never blocking the writer.
+      class Reader
+      {
+      public:
+         Reader() {}
+         ~Reader();
+
+         Reader(const Reader&) = delete;
+         Reader& operator = (const Reader&) = delete;
+
+         bool open(const std::string& name); // false if the object doesn't exist (yet) or isn't a SharedTelemetry object
+         void close();
+
+         std::vector<ColumnInfo> columns;
+
+         const ColumnInfo* find(const std::string& name) const; // nullptr if not found
+
+         uint64_t frames() const; // number of frames published so far
+
+         /** Read frame number index, false if it hasn't been published or has already been overwritten. */
+         bool read(const uint64_t index, Frame& frame) const;
+
+         /** Read the most recently published frame, false if none has been published. */
+         bool latest(Frame& frame) const;
+
+         /** Read up to n of the most recent frames, oldest first. Returns the number of frames read. */
+         size_t window(const size_t n, std::vector<Frame>& frames) const;
+
+      private:
+         const Header* header = nullptr;
+         size_t bytes = 0;
+      };
+   }
+}
\ No newline at end of file
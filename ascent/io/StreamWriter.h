@@ -0,0 +1,116 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+// StreamWriter appends tracked data to output files on a background thread while a simulation runs, so long runs don't need to hold their whole history in memory.
+// The simulation thread copies each row's raw values into a block. Full blocks are handed to the writer thread through a lock-free SPSCQueue,
+// and returned through another once written, so no allocation occurs after construction. Formatting happens on the writer thread.
+
+#include "ascent/core/SPSCQueue.h"
+#include "ascent/io/BinaryTrack.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace asc
+{
+   class StreamWriter
+   {
+   public:
+      struct Field
+      {
+         BinaryTrack::Layout layout; // if the layout isn't supported, the value is passed as a formatted string
+         uint8_t flags = 0; // BinaryTrack::Flags
+         bool optional = false; // the field may be left blank in a row with skip(), such as a variable tracked at a different rate than the rest of the row
+      };
+
+      class Stream
+      {
+      private:
+         friend class StreamWriter;
+
+         std::ofstream file;
+         std::vector<Field> fields;
+
+      public:
+         std::string filename;
+      };
+
+      StreamWriter(const size_t block_size = 1 << 16, const size_t n_blocks = 64); // at most block_size * n_blocks bytes are held for writing
+      ~StreamWriter(); // writes all pending rows
+
+      StreamWriter(const StreamWriter&) = delete;
+      StreamWriter& operator = (const StreamWriter&) = delete;
+
+      /** Create a file starting with the header line. Returns nullptr if the file couldn't be created. */
+      Stream* open(const std::string& filename, const std::string& header, const std::vector<Field>& fields);
+      void close(Stream* stream); // writes all pending rows, then closes the file
+
+      // A row is written by calling beginRow(), then value() (or skip() for an optional field) for each field in order, then endRow().
+      void beginRow(Stream* stream);
+      void value(const void* data, const size_t bytes);
+      void value(const std::string& formatted);
+      void skip();
+      void endRow();
+
+      /** Hand all complete rows to the writer thread and wait until they're written to their files. Returns false if writing has failed. */
+      bool flush();
+
+   private:
+      struct Block
+      {
+         std::vector<char> data;
+         bool flush = false; // whether the files should be flushed after this block is written
+      };
+
+      const size_t block_size;
+      std::vector<std::unique_ptr<Block>> blocks; // owns all blocks
+      std::vector<std::unique_ptr<Stream>> streams; // owns all streams
+
+      SPSCQueue<Block*> full_blocks; // simulation thread -> writer thread
+      SPSCQueue<Block*> free_blocks; // writer thread -> simulation thread
+
+      Block* block = nullptr; // block being filled by the simulation thread
+      size_t row_begin = 0; // offset of the row being filled
+      bool in_row = false;
+      Stream* row_stream = nullptr; // stream of the row being filled
+      size_t field = 0; // index of the next field of the row being filled
+
+      void present(const bool filled); // marks whether an optional field has a value in the row
+      size_t pushed = 0; // number of blocks handed to the writer thread
+
+      std::atomic<size_t> written{ 0 }; // number of blocks written by the writer thread
+      std::atomic<bool> failed{ false };
+      std::atomic<bool> stopping{ false };
+
+      std::mutex wake_mutex; // only used for the writer thread to sleep while there's nothing to write
+      std::condition_variable wake;
+
+      std::thread thread;
+
+      void append(const void* data, const size_t bytes);
+      void push(); // hand the current block to the writer thread
+
+      void run(); // writer thread
+      void write(const Block& block, std::vector<Stream*>& touched);
+   };
+}
\ No newline at end of file
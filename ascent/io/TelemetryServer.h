@@ -0,0 +1,92 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+// TelemetryServer serves JsonAPI requests to other processes over a Unix domain socket while a simulation runs (POSIX only).
+// Frames in both directions are a uint32 length (native byte order) followed by that many bytes of JSON text.
+//
+// A request is a JsonAPI::io input (an array of module objects), answered with the JsonAPI::io output.
+// A subscription, {"subscribe": <JsonAPI::io input>, "every": N}, is answered every N full steps with {"t": <time>, "output": <JsonAPI::io output>}
+// until the client sends {"unsubscribe": true} or disconnects. Bad requests are answered with {"error": <description>} and don't stop the simulation.
+//
+// The socket is handled by a background thread, but requests are applied by the simulation thread between full steps (see service()), so they never race with module updates.
+// While no client is connected, service() only reads an atomic counter.
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace asc
+{
+   class Simulator;
+
+   class TelemetryServer
+   {
+   public:
+      TelemetryServer() {}
+      ~TelemetryServer(); // stops the server and removes the socket file
+
+      TelemetryServer(const TelemetryServer&) = delete;
+      TelemetryServer& operator = (const TelemetryServer&) = delete;
+
+      static const uint32_t max_frame = 1 << 26; // larger frames are refused by closing the connection
+
+      bool start(const std::string& socket_path); // false if the socket couldn't be created (always on Windows)
+      void stop();
+
+      /** Apply pending requests and send due subscriptions, called by the simulation thread between full steps. */
+      void service(Simulator& simulator);
+
+      size_t clients() const { return connected.load(std::memory_order_relaxed); }
+
+   private:
+      struct Message
+      {
+         uint64_t client;
+         std::string text;
+      };
+
+      struct Subscription
+      {
+         uint64_t client;
+         std::string input; // JsonAPI::io input
+         size_t every;
+      };
+
+      std::string path;
+      int listen_fd = -1;
+      int wake_fds[2] = { -1, -1 }; // pipe that wakes the server thread when responses are queued or it's stopping
+      std::thread thread;
+      std::atomic<bool> running{ false };
+      std::atomic<size_t> connected{ 0 };
+
+      std::mutex mutex; // guards requests, responses and disconnected
+      std::deque<Message> requests;
+      std::deque<Message> responses;
+      std::vector<uint64_t> disconnected;
+
+      std::vector<Subscription> subscriptions; // simulation thread only
+      size_t steps = 0; // full steps serviced while clients were connected
+
+      void run(); // server thread
+      void wake();
+      std::string handle(Simulator& simulator, const uint64_t client, const std::string& request);
+   };
+}
\ No newline at end of file
@@ -17,13 +17,7 @@
 
 #include "ascent/Link.h"
 
-// Protecting json max/min macros from ChaiScript windows max/min macros
-#undef max
-#undef min
-
-#include "jsoncons/json.hpp"
-#include "jsoncons/json_deserializer.hpp"
-#include "jsoncons_ext/csv/csv_reader.hpp"
+#include <thread>
 
 using namespace asc;
 using namespace std;
@@ -45,12 +39,15 @@ void ModuleCore::error(const size_t sim, const std::string& description)
 
 Module& ModuleCore::getExternal(const std::string& name)
 {
-   return *external[name];
+   auto it = external.find(name);
+   if (it == external.end() || !it->second)
+      throw std::runtime_error("Module <" + name + "> could not be located.");
+   return *it->second;
 }
 
 Module& ModuleCore::getModule(const size_t id)
 {
-   return *accessor[id];
+   return *accessor.at(id); // doesn't insert, so simulators running in parallel can look up modules
 }
 
 Simulator& ModuleCore::getSimulator(const size_t sim)
@@ -102,9 +99,25 @@ void Module::addPhases()
 
 Module::~Module()
 {
+   if (stream)
+      simulator.stream_writer->close(stream);
+
+   if (simulator.streamers.count(module_id))
+      simulator.streamers.directErase(module_id);
+
+   if (simulator.publishers.count(module_id))
+      simulator.publishers.directErase(module_id);
+
    for (State* state : states)
       delete state;
 
+   // Snapshot copies are detached here rather than by ~Parameter, because the simulator may be erased below, before vars is destroyed.
+   for (auto& parameter : vars.parameters)
+   {
+      if (parameter->snapshotted)
+         simulator.snapshot.detach(parameter->data());
+   }
+
    ModuleCore::accessor.erase(module_id);
 
    if (ModuleCore::external.count(module_name))
@@ -164,6 +177,7 @@ void Module::addIntegrator(double &x, double &xd, const double tolerance)
    if (!simulator.propagate.count(module_id)) // if no integrators have been added (i.e. this module hasn't been added to be propagated)
       simulator.propagate[module_id] = this;
 
+   Arena::Scope scope(simulator.arena.get());
    states.push_back(simulator.integrator->factory(x, xd));
    states.back()->tolerance = tolerance;
 }
@@ -174,6 +188,18 @@ void Module::propagateStates()
       state->propagate();
 }
 
+void Module::changeIntegrator()
+{
+   Arena::Scope scope(simulator.arena.get());
+   for (State*& state : states)
+   {
+      State* changed = simulator.integrator->factory(state->x, state->xd);
+      changed->tolerance = state->tolerance;
+      delete state;
+      state = changed;
+   }
+}
+
 void Module::callInit()
 {
    if (!init_run)
@@ -195,20 +221,20 @@ void Module::callInit()
 
 void Module::callUpdate()
 {
-   if (!update_run)
+   if (!ran())
    {
       std::vector<size_t> to_delete;
       for (auto& p : run_first)
       {
          if (auto ptr = p.second.lock())
          {
-            if (!ptr->update_run)
+            if (!ptr->ran())
             {
                if (ptr->update_called) // If the run_first map contains an updating module, then we shouldn't update this module yet.
                   return;
 
                ptr->callUpdate();
-               if (!ptr->update_run) // If the call to update didn't update the module, then we shouldn't update this module yet.
+               if (!ptr->ran()) // If the call to update didn't update the module, then we shouldn't update this module yet.
                   return;
             }
          }
@@ -228,27 +254,27 @@ void Module::callUpdate()
             update();
       }
       
-      update_run = true;
+      run_epoch = simulator.epoch;
       update_called = false;
    }
 }
 
 void Module::callPostCalc()
 {
-   if (!postcalc_run)
+   if (!ran())
    {
       std::vector<size_t> to_delete;
       for (auto& p : run_first)
       {
          if (auto ptr = p.second.lock())
          {
-            if (!ptr->postcalc_called)
+            if (!ptr->ran())
             {
                if (ptr->postcalc_called)
                   return;
 
                ptr->callPostCalc();
-               if (!ptr->postcalc_run)
+               if (!ptr->ran())
                   return;
             }
          }
@@ -268,14 +294,14 @@ void Module::callPostCalc()
             postcalc();
       }
       
-      postcalc_run = true;
+      run_epoch = simulator.epoch;
       postcalc_called = false;
    }
 }
 
 void Module::callCheck()
 {
-   if (!check_run)
+   if (!ran())
    {
       if (check_called)
          error("Circular dependency for check().");
@@ -286,14 +312,14 @@ void Module::callCheck()
             check();
       }
       
-      check_run = true;
+      run_epoch = simulator.epoch;
       check_called = false;
    }
 }
 
 void Module::callReport()
 {
-   if (!report_run)
+   if (!ran())
    {
       if (report_called)
          error("Circular dependency for report().");
@@ -304,14 +330,14 @@ void Module::callReport()
             report();
       }
       
-      report_run = true;
+      run_epoch = simulator.epoch;
       report_called = false;
    }
 }
 
 void Module::callReset()
 {
-   if (!reset_run)
+   if (!ran())
    {
       if (reset_called)
          error("Circular dependency for reset().");
@@ -322,11 +348,58 @@ void Module::callReset()
             reset();
       }
       
-      reset_run = true;
+      run_epoch = simulator.epoch;
       reset_called = false;
    }
 }
 
+void Module::callAccess()
+{
+   const Phase phase = simulator.phase;
+
+   if (phase != Phase::setup)
+   {
+      // For all phases except "setup", init() must have been called prior to access.
+      // Calling the method callInit() ensures that initialization has been properly handled. Once a module has been initialized this method will simply do nothing.
+      // This call is essential for simulations that add modules during the simulation loop.
+      callInit();
+
+      switch (phase)
+      {
+      case Phase::update:
+         callUpdate();
+         break;
+      case Phase::postcalc:
+         callPostCalc();
+         break;
+      case Phase::check:
+         callCheck();
+         break;
+      case Phase::reset:
+         callReset();
+         break;
+      default:
+         break;
+      }
+
+      if (!init_run)
+         return;
+
+      switch (phase)
+      {
+      case Phase::update:
+      case Phase::postcalc:
+         if (!ran())
+            return; // waiting on a run_first module, so access must be handled again
+         break;
+      default:
+         break;
+      }
+   }
+
+   access_epoch = simulator.epoch;
+}
+
 void Module::track(const std::string& var_name)
 {
    if ("t" == var_name)
@@ -337,7 +410,7 @@ void Module::track(const std::string& var_name)
    else
    {
       tracking.push_back(std::make_pair(module_id, var_name));
-      steps(var_name);
+      trackSteps(*this, var_name);
    }
 
    local_tracking.insert(var_name);
@@ -358,19 +431,366 @@ void Module::track(Module& module, const std::string& var_name)
    else
    {
       tracking.push_back(std::make_pair(module.module_id, var_name));
-      ModuleCore::getModule(module.module_id).steps(var_name);
+      trackSteps(ModuleCore::getModule(module.module_id), var_name);
+   }
+}
+
+void Module::track(const std::string& var_name, const Rate& rate)
+{
+   track(var_name);
+   vars.rate(var_name, rate);
+}
+
+void Module::track(Module& module, const std::string& var_name, const Rate& rate)
+{
+   track(module, var_name);
+   module.vars.rate(var_name, rate);
+}
+
+void Module::trackRate(const Rate& rate)
+{
+   track_rate = rate;
+   stream_decimator = Decimator(rate);
+
+   if (rate.sdt > 0.0)
+      simulator.track_samples.insert(rate.sdt);
+
+   for (auto& p : tracking)
+      getModule(p.first).vars.rate(p.second, rate);
+}
+
+void Module::trackSteps(Module& module, const std::string& var_name)
+{
+   if (streaming)
+   {
+      module.vars.steps(var_name, false);
+      module.vars.steps(var_name, stream_retention);
+   }
+   else
+      module.steps(var_name);
+
+   if (!track_rate.all())
+      module.vars.rate(var_name, track_rate);
+}
+
+void Module::streamFiles(const size_t retention)
+{
+   if (file_type == ".ascb" || file_type == ".json")
+      error("Binary and JSON files can't be streamed, use csv or txt files with streamFiles().");
+
+   streaming = true;
+   stream_retention = retention;
+
+   for (auto& p : tracking) // variables that were already tracked
+      trackSteps(getModule(p.first), p.second);
+
+   if (!simulator.stream_writer)
+      simulator.stream_writer = std::make_shared<StreamWriter>();
+
+   simulator.streamers[module_id] = this;
+}
+
+bool Module::checkpoint(const std::string& file_name)
+{
+   std::ofstream file(file_name, std::ios::binary);
+   if (!file)
+      return error("Checkpoint file " + file_name + " could not be created.");
+   return simulator.checkpoint(file);
+}
+
+bool Module::restore(const std::string& file_name)
+{
+   std::ifstream file(file_name, std::ios::binary);
+   if (!file)
+      return error("Checkpoint file " + file_name + " could not be opened.");
+   return simulator.restore(file);
+}
+
+std::vector<size_t> Module::fork(const size_t n, const std::function<void(size_t sim)>& build)
+{
+   if (simulator.phase != Phase::setup && simulator.phase != Phase::report)
+   {
+      error("Simulators can only be forked between runs or from report().");
+      return{};
+   }
+
+   Archive archive;
+   archive.sharing = true; // histories are shared with the children rather than copied
+   simulator.serialize(archive);
+
+   std::vector<size_t> sims;
+   for (size_t i = 0; i < n; ++i)
+   {
+      const size_t child = ModuleCore::simulators.rbegin()->first + 1; // an unused simulator number
+      build(child);
+
+      Archive restorer = archive.restorer();
+      getSimulator(child).restore(restorer);
+      sims.push_back(child);
+   }
+   return sims;
+}
+
+void Module::serializeModule(Archive& archive, const std::vector<Module*>& order, const std::map<size_t, size_t>& positions)
+{
+   std::string module_type = type();
+   archive(module_type);
+   if (module_type != type())
+      throw runtime_error("module " + name() + " is a " + type() + ", but the checkpoint holds a " + module_type + " in its place.");
+
+   archive(frozen, freeze_integration, stop, init_run);
+
+   // Phases the module has left (e.g. after init() or a default update()) stay left.
+   for (DynamicMap<size_t, Module*>* phase : { &simulator.inits, &simulator.updates, &simulator.postcalcs, &simulator.checks, &simulator.reports, &simulator.resets })
+   {
+      bool member = phase->count(module_id) > 0;
+      archive(member);
+      if (archive.loading())
+      {
+         if (member)
+            (*phase)[module_id] = this;
+         else
+            phase->directErase(module_id);
+      }
+   }
+
+   const size_t n_states = archive.size(states.size());
+   if (n_states != states.size())
+      throw runtime_error("module " + name() + " has " + to_string(states.size()) + " integrated states, but the checkpoint holds " + to_string(n_states) + ".");
+   for (State* state : states)
+      state->serialize(archive);
+
+   vars.serialize(archive);
+
+   // Wiring, other modules are stored by their position in the simulator (modules of other simulators aren't restored).
+   auto position = [&](const size_t id) -> uint64_t
+   {
+      auto it = positions.find(id);
+      return (it == positions.end()) ? UINT64_MAX : it->second;
+   };
+
+   archive(print_time);
+
+   size_t n = archive.size(tracking.size());
+   std::vector<std::pair<size_t, std::string>> tracked;
+   for (size_t i = 0; i < n; ++i)
+   {
+      uint64_t index = archive.loading() ? 0 : position(tracking[i].first);
+      std::string var_name = archive.loading() ? "" : tracking[i].second;
+      archive(index, var_name);
+      if (index < order.size())
+         tracked.emplace_back(order[index]->module_id, var_name);
+   }
+   if (archive.loading())
+      tracking = tracked;
+
+   std::vector<std::string> local(local_tracking.begin(), local_tracking.end());
+   archive(local);
+   if (archive.loading())
+      local_tracking = std::unordered_set<std::string>(local.begin(), local.end());
+
+   std::vector<uint64_t> first; // modules that run before this one
+   for (auto& p : run_first)
+   {
+      if (!p.second.expired())
+         first.push_back(position(p.first));
+   }
+   archive(first);
+   if (archive.loading())
+   {
+      run_first.clear();
+      for (uint64_t index : first)
+      {
+         if (index < order.size())
+            run_first[order[index]->module_id] = order[index]->myself;
+      }
+   }
+
+   n = archive.size(links.size());
+   auto link = links.begin();
+   for (size_t i = 0; i < n; ++i)
+   {
+      std::string link_name;
+      uint64_t index = UINT64_MAX;
+      if (!archive.loading())
+      {
+         link_name = link->first;
+         auto linked = link->second->linkedModule();
+         if (linked.first)
+            index = position(linked.second);
+         ++link;
+      }
+      archive(link_name, index);
+
+      if (archive.loading() && index < order.size() && links.count(link_name))
+         links[link_name]->assign(*order[index]);
+   }
+
+   const size_t block = archive.begin(); // the module's own state, so that a module that reads less than it saved doesn't misalign the modules after it
+   serialize(archive);
+   archive.end(block);
+}
+
+void Module::serveTelemetry(const std::string& socket_path)
+{
+   if (!simulator.telemetry)
+      simulator.telemetry = std::make_shared<TelemetryServer>();
+
+   if (!simulator.telemetry->start(socket_path))
+      error("Telemetry socket " + socket_path + " could not be created.");
+}
+
+void Module::snapshot(const std::string& var_name)
+{
+   ParameterBase* parameter = vars.find(var_name);
+   if (parameter)
+      parameter->snapshot();
+}
+
+void Module::shareTelemetry(const std::string& name, const size_t capacity)
+{
+   shared_name = name;
+   shared_capacity = capacity;
+   shared_telemetry.reset();
+   shared_values.clear();
+
+   simulator.publishers[module_id] = this;
+}
+
+void Module::shareRow()
+{
+   if (!shared_telemetry) // first frame, so resolve the tracked variables and create the shared memory
+   {
+      vector<SharedTelemetry::Writer::Column> columns;
+      for (auto& p : tracking)
+      {
+         ParameterBase* parameter = getModule(p.first).vars.findTrackable(p.second, "shareRow");
+         if (!parameter)
+            return;
+
+         SharedTelemetry::Writer::Column column;
+         column.name = getModule(p.first).name() + " " + p.second;
+         column.layout = parameter->binaryLayout();
+         if (!column.layout.supported)
+            error("Variable <" + p.second + "> of type <" + parameter->type() + "> can't be shared, only numeric and fixed size Eigen types can be.");
+         if (column.name.size() >= SharedTelemetry::name_size)
+            error("Shared column name <" + column.name + "> is longer than " + to_string(SharedTelemetry::name_size - 1) + " characters, use a shorter module name.");
+
+         columns.push_back(column);
+         shared_values.push_back(parameter->data());
+      }
+
+      shared_telemetry = std::make_unique<SharedTelemetry::Writer>();
+      if (!shared_telemetry->open(shared_name, columns, shared_capacity))
+         error("Shared memory " + shared_name + " could not be created.");
    }
+
+   shared_telemetry->write(simulator.t, shared_values);
+}
+
+void Module::streamRow()
+{
+   StreamWriter& writer = *simulator.stream_writer;
+
+   if (!stream) // first row, so resolve the tracked variables and write the header
+   {
+      string header;
+      vector<StreamWriter::Field> fields;
+
+      if (print_time)
+      {
+         header += "t,";
+         StreamWriter::Field field;
+         field.layout = BinaryTrack::Type<double>::layout();
+         field.flags = BinaryTrack::Flags::time_column;
+         fields.push_back(field);
+      }
+
+      size_t n = tracking.size();
+      for (size_t i = 0; i < n; ++i)
+      {
+         auto& p = tracking[i];
+         ParameterBase* parameter = getModule(p.first).vars.findTrackable(p.second, "streamRow");
+         if (!parameter)
+            return;
+         stream_columns.push_back(parameter);
+         stream_decimators.emplace_back(parameter->rate);
+
+         StreamWriter::Field field;
+         field.layout = parameter->binaryLayout();
+         field.optional = true; // left blank in the rows between the variable's samples
+         fields.push_back(field);
+
+         header += getModule(p.first).name() + " " + p.second;
+         if (i < n - 1) // not the last parameter
+            header += ",";
+      }
+
+      string filename = module_directory + module_name + file_type;
+      stream = writer.open(filename, header, fields);
+      if (!stream)
+         error("File " + filename + " could not be created.");
+   }
+
+   const size_t n = stream_columns.size();
+   stream_due.resize(n);
+   bool due = (n == 0) && stream_decimator.due(simulator.t, simulator.EPS);
+   for (size_t j = 0; j < n; ++j)
+   {
+      Decimator& decimator = stream_decimators[j];
+      const Rate& rate = stream_columns[j]->rate;
+      if (rate.sdt != decimator.rate.sdt || rate.decimation != decimator.rate.decimation) // the rate was changed while streaming
+         decimator = Decimator(rate);
+
+      stream_due[j] = decimator.due(simulator.t, simulator.EPS);
+      due = due || stream_due[j];
+   }
+
+   if (!due)
+      return;
+
+   writer.beginRow(stream);
+
+   if (print_time)
+      writer.value(&simulator.t, sizeof(double));
+
+   for (size_t j = 0; j < n; ++j)
+   {
+      ParameterBase* parameter = stream_columns[j];
+      BinaryTrack::Layout layout = parameter->binaryLayout();
+      if (!stream_due[j])
+         writer.skip();
+      else if (layout.supported)
+         writer.value(parameter->data(), layout.bytes());
+      else
+         writer.value(parameter->printCurrent());
+   }
+
+   writer.endRow();
 }
 
 void Module::outputTrack()
 {
+   if (stream) // already written while running
+   {
+      if (!simulator.stream_writer->flush())
+         error("Streaming tracked data to file failed.");
+      return;
+   }
+
    ofstream file;
    string filename = module_directory + module_name + file_type;
-   file.open(filename);
+   const bool binary = (file_type == ".ascb");
+   file.open(filename, binary ? ios::out | ios::binary : ios::out);
 
    if (file)
    {
-      streamTrack(file);
+      if (binary)
+         binaryTrack(file);
+      else if (file_type == ".json")
+         jsonTrack(file, JsonLayout::columns);
+      else
+         streamTrack(file);
    }
    else
       error("File " + filename + " could not be created.");
@@ -387,18 +807,149 @@ std::string Module::csvTrack()
    return ss.str();
 }
 
-std::string Module::jsonTrack()
+std::string Module::jsonTrack(const JsonLayout layout)
 {
-   stringstream ss{};
+   string output;
+   JsonWriter writer(output);
+   jsonTrack(writer, layout);
+   return output;
+}
 
-   streamTrack(ss);
+void Module::jsonTrack(std::ostream& stream, const JsonLayout layout)
+{
+   JsonWriter writer(stream);
+   jsonTrack(writer, layout);
+}
+
+void Module::jsonTrack(JsonWriter& writer, const JsonLayout layout)
+{
+   vector<ParameterBase*> columns; // resolved once, values are written straight from their histories
+   vector<string> names;
+   for (auto& p : tracking)
+   {
+      ParameterBase* parameter = getModule(p.first).vars.findTrackable(p.second, "jsonTrack");
+      if (!parameter)
+         return;
+      columns.push_back(parameter);
+      names.push_back(getModule(p.first).name() + " " + p.second);
+   }
+
+   const size_t n = columns.size();
+
+   // Variables tracked at different rates share rows by time, with null where a variable has no sample.
+   auto cell = [&](const TrackRows& rows, const size_t j)
+   {
+      if (rows.has(j))
+         columns[j]->formatJson(writer.value(), rows.sample(j));
+      else
+         writer.value() += "null";
+   };
+
+   if (layout == JsonLayout::rows)
+   {
+      writer.beginArray();
+
+      writer.beginArray();
+      if (print_time)
+         writer.value("t");
+      for (auto& name : names)
+         writer.value(name);
+      writer.endArray();
+
+      TrackRows rows(columns);
+      while (rows.advance())
+      {
+         writer.beginArray();
+         if (print_time)
+            writer.value(simulator.t_hist[rows.t_index]);
+         for (size_t j = 0; j < n; ++j)
+            cell(rows, j);
+         writer.endArray();
+      }
+
+      writer.endArray();
+   }
+   else
+   {
+      writer.beginObject();
 
-   jsoncons::json_deserializer handler;
+      const bool aligned = TrackRows(columns).aligned(); // every column has a value for every time, so each is written straight from its history
 
-   jsoncons::csv::csv_reader reader(ss, handler);
-   reader.read();
+      if (print_time && n > 0)
+      {
+         writer.key("t");
+         writer.beginArray();
+         TrackRows rows(columns);
+         while (rows.advance())
+            writer.value(simulator.t_hist[rows.t_index]);
+         writer.endArray();
+      }
+
+      for (size_t j = 0; j < n; ++j)
+      {
+         writer.key(names[j]);
+         writer.beginArray();
+         if (aligned)
+         {
+            const size_t m = columns[j]->length();
+            for (size_t i = 0; i < m; ++i)
+               columns[j]->formatJson(writer.value(), i);
+         }
+         else
+         {
+            TrackRows rows(columns);
+            while (rows.advance())
+               cell(rows, j);
+         }
+         writer.endArray();
+      }
 
-   return handler.get_result().to_string();
+      writer.endObject();
+   }
+}
+
+void Module::binaryTrack(std::ostream& stream)
+{
+   vector<BinaryTrack::Source> sources;
+   vector<ParameterBase*> columns;
+
+   for (auto& p : tracking)
+   {
+      ParameterBase* parameter = getModule(p.first).vars.findTrackable(p.second, "binaryTrack");
+      if (!parameter)
+         return;
+
+      BinaryTrack::Source source;
+      source.name = getModule(p.first).name() + " " + p.second;
+      source.layout = parameter->binaryLayout();
+      if (!source.layout.supported)
+         error("Variable <" + p.second + "> of type <" + parameter->type() + "> can't be written in binary.");
+      source.length = parameter->length();
+      source.write = [parameter](std::ostream& stream) { parameter->writeBinary(stream); };
+
+      columns.push_back(parameter);
+      sources.push_back(source);
+   }
+
+   if (!TrackRows(columns).aligned()) // binary columns are dense, so they must all be recorded at the times of the single time column
+      error("Variables tracked at different rates or from different times can't be written to the same binary file, use csv or json files instead.");
+
+   if (print_time)
+   {
+      BinaryTrack::Source source;
+      source.name = "t";
+      source.layout = BinaryTrack::Type<double>::layout();
+      source.flags = BinaryTrack::Flags::time_column;
+      auto t = make_shared<vector<double>>();
+      TrackRows rows(columns);
+      while (rows.advance())
+         t->push_back(simulator.t_hist[rows.t_index]);
+      source.length = t->size();
+      source.write = [t](std::ostream& stream) { BinaryTrack::write(stream, Span<const double>(t->data(), t->size())); };
+      sources.insert(sources.begin(), source);
+   }
+
+   BinaryTrack::write(stream, sources);
 }
 
 void Module::streamCSV(std::shared_ptr<std::stringstream>& ss)
@@ -500,4 +1051,39 @@ void asc::generateInputFile(const std::string& file_name)
          file << '\n';
       }
    }
+}
+
+bool asc::runParallel(const std::vector<size_t>& sims, const double dt_base, const double t_end)
+{
+   std::vector<Simulator*> simulators;
+   for (size_t sim : sims)
+      simulators.push_back(&ModuleCore::getSimulator(sim)); // looked up before the threads start, because the simulator table isn't thread safe
+
+   std::vector<char> succeeded(sims.size(), false);
+   std::vector<std::thread> threads;
+   for (size_t i = 0; i < simulators.size(); ++i)
+   {
+      threads.emplace_back([&, i]
+      {
+         try
+         {
+            succeeded[i] = simulators[i]->run(dt_base, t_end);
+         }
+         catch (const std::exception&) {} // the error is recorded by the simulator
+      });
+   }
+
+   for (std::thread& thread : threads)
+      thread.join();
+
+   return std::all_of(succeeded.begin(), succeeded.end(), [](const char b) { return b != 0; });
+}
+
+void asc::arena(const size_t sim, const size_t block_size)
+{
+   Simulator& simulator = ModuleCore::getSimulator(sim);
+   if (simulator.modules.size() > 0)
+      simulator.setError("An arena must be set before the modules of simulator " + to_string(sim) + " are created.");
+
+   simulator.arena = std::make_shared<Arena>(block_size);
 }
\ No newline at end of file
@@ -0,0 +1,80 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ascent/core/Arena.h"
+
+#include <algorithm>
+#include <new>
+
+using namespace asc;
+
+namespace
+{
+   thread_local Arena* current_arena = nullptr;
+
+   constexpr size_t header = alignof(std::max_align_t); // ArenaAllocated objects are preceded by a header recording whether they came from an arena
+}
+
+void* Arena::allocate(const size_t bytes, const size_t alignment)
+{
+   size_t padding = (alignment - reinterpret_cast<uintptr_t>(head) % alignment) % alignment;
+   if (!head || padding + bytes > remaining)
+   {
+      const size_t size = std::max(block_size, bytes + alignment);
+      blocks.emplace_back(new char[size]);
+      head = blocks.back().get();
+      remaining = size;
+      reserved += size;
+      padding = (alignment - reinterpret_cast<uintptr_t>(head) % alignment) % alignment;
+   }
+
+   char* p = head + padding;
+   head += padding + bytes;
+   remaining -= padding + bytes;
+   used += padding + bytes;
+   return p;
+}
+
+Arena::Scope::Scope(Arena* arena) : previous(current_arena)
+{
+   current_arena = arena;
+}
+
+Arena::Scope::~Scope()
+{
+   current_arena = previous;
+}
+
+Arena* Arena::current()
+{
+   return current_arena;
+}
+
+void* ArenaAllocated::operator new(const size_t bytes)
+{
+   Arena* arena = current_arena;
+   char* base = static_cast<char*>(arena ? arena->allocate(header + bytes) : ::operator new(header + bytes));
+   *reinterpret_cast<bool*>(base) = (arena != nullptr);
+   return base + header;
+}
+
+void ArenaAllocated::operator delete(void* p) noexcept
+{
+   if (!p)
+      return;
+
+   char* base = static_cast<char*>(p) - header;
+   if (!*reinterpret_cast<bool*>(base))
+      ::operator delete(base);
+}
\ No newline at end of file
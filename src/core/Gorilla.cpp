@@ -0,0 +1,303 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "ascent/core/Gorilla.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace asc;
+using namespace std;
+
+namespace
+{
+   uint64_t toBits(const double x)
+   {
+      uint64_t bits;
+      memcpy(&bits, &x, sizeof(double));
+      return bits;
+   }
+
+   double fromBits(const uint64_t bits)
+   {
+      double x;
+      memcpy(&x, &bits, sizeof(double));
+      return x;
+   }
+
+   uint64_t mask(const unsigned n) { return (n >= 64) ? ~uint64_t(0) : (uint64_t(1) << n) - 1; }
+
+   unsigned leadingZeros(uint64_t x) // x != 0
+   {
+      unsigned n = 0;
+      while (!(x & (uint64_t(1) << 63)))
+      {
+         x <<= 1;
+         ++n;
+      }
+      return n;
+   }
+
+   unsigned trailingZeros(uint64_t x) // x != 0
+   {
+      unsigned n = 0;
+      while (!(x & 1))
+      {
+         x >>= 1;
+         ++n;
+      }
+      return n;
+   }
+
+   // Writes bits most significant first.
+   class BitWriter
+   {
+   private:
+      vector<uint64_t>& words;
+      unsigned used = 64; // bits used in the last word
+
+   public:
+      BitWriter(vector<uint64_t>& words) : words(words) {}
+
+      void write(const uint64_t value, unsigned n) // writes the low n bits of value, 1 <= n <= 64
+      {
+         while (n > 0)
+         {
+            if (used == 64)
+            {
+               words.push_back(0);
+               used = 0;
+            }
+
+            const unsigned space = 64 - used;
+            const unsigned take = min(space, n);
+            const uint64_t part = (value >> (n - take)) & mask(take);
+            words.back() |= part << (space - take);
+            used += take;
+            n -= take;
+         }
+      }
+
+      void bit(const bool b) { write(b ? 1 : 0, 1); }
+   };
+
+   class BitReader
+   {
+   private:
+      const uint64_t* words;
+      size_t position = 0; // in bits
+
+   public:
+      BitReader(const uint64_t* words) : words(words) {}
+
+      uint64_t read(unsigned n) // 1 <= n <= 64
+      {
+         uint64_t value = 0;
+         while (n > 0)
+         {
+            const unsigned used = position % 64;
+            const unsigned space = 64 - used;
+            const unsigned take = min(space, n);
+            const uint64_t part = (words[position / 64] >> (space - take)) & mask(take);
+            value = (take == 64) ? part : (value << take) | part;
+            position += take;
+            n -= take;
+         }
+         return value;
+      }
+
+      bool bit() { return read(1) != 0; }
+   };
+
+   struct XorLane
+   {
+      uint64_t previous = 0;
+      unsigned leading = 0;
+      unsigned trailing = 0;
+      bool window = false; // whether leading and trailing describe a previous meaningful bit window
+   };
+}
+
+void Gorilla::encodeXor(const double* values, const size_t n, const size_t lanes, std::vector<uint64_t>& out)
+{
+   BitWriter writer(out);
+   vector<XorLane> state(lanes);
+
+   for (size_t i = 0; i < n; ++i)
+   {
+      for (size_t k = 0; k < lanes; ++k)
+      {
+         XorLane& lane = state[k];
+         const uint64_t bits = toBits(values[i * lanes + k]);
+
+         if (i == 0)
+            writer.write(bits, 64);
+         else
+         {
+            const uint64_t x = bits ^ lane.previous;
+            if (x == 0)
+               writer.bit(false);
+            else
+            {
+               writer.bit(true);
+
+               const unsigned leading = min(leadingZeros(x), 31u); // stored in 5 bits
+               const unsigned trailing = trailingZeros(x);
+
+               if (lane.window && leading >= lane.leading && trailing >= lane.trailing) // fits in the previous window
+               {
+                  writer.bit(false);
+                  writer.write(x >> lane.trailing, 64 - lane.leading - lane.trailing);
+               }
+               else
+               {
+                  const unsigned meaningful = 64 - leading - trailing;
+                  writer.bit(true);
+                  writer.write(leading, 5);
+                  writer.write(meaningful - 1, 6);
+                  writer.write(x >> trailing, meaningful);
+
+                  lane.leading = leading;
+                  lane.trailing = trailing;
+                  lane.window = true;
+               }
+            }
+         }
+
+         lane.previous = bits;
+      }
+   }
+}
+
+void Gorilla::decodeXor(const uint64_t* in, double* values, const size_t n, const size_t lanes)
+{
+   BitReader reader(in);
+   vector<XorLane> state(lanes);
+
+   for (size_t i = 0; i < n; ++i)
+   {
+      for (size_t k = 0; k < lanes; ++k)
+      {
+         XorLane& lane = state[k];
+
+         if (i == 0)
+            lane.previous = reader.read(64);
+         else if (reader.bit())
+         {
+            if (reader.bit()) // new window
+            {
+               lane.leading = static_cast<unsigned>(reader.read(5));
+               const unsigned meaningful = static_cast<unsigned>(reader.read(6)) + 1;
+               lane.trailing = 64 - lane.leading - meaningful;
+            }
+
+            const unsigned meaningful = 64 - lane.leading - lane.trailing;
+            lane.previous ^= reader.read(meaningful) << lane.trailing;
+         }
+
+         values[i * lanes + k] = fromBits(lane.previous);
+      }
+   }
+}
+
+void Gorilla::encodeDeltaOfDelta(const double* values, const size_t n, std::vector<uint64_t>& out)
+{
+   BitWriter writer(out);
+   uint64_t previous = 0;
+   uint64_t delta = 0;
+
+   for (size_t i = 0; i < n; ++i)
+   {
+      const uint64_t bits = toBits(values[i]);
+
+      if (i == 0)
+         writer.write(bits, 64);
+      else if (i == 1)
+      {
+         delta = bits - previous;
+         writer.write(delta, 64);
+      }
+      else
+      {
+         const uint64_t next_delta = bits - previous;
+         const int64_t dod = static_cast<int64_t>(next_delta - delta); // wraps, so any bit pattern round trips
+
+         if (dod == 0)
+            writer.bit(false);
+         else if (dod >= -63 && dod <= 64)
+         {
+            writer.write(0x2, 2);
+            writer.write(static_cast<uint64_t>(dod + 63), 7);
+         }
+         else if (dod >= -255 && dod <= 256)
+         {
+            writer.write(0x6, 3);
+            writer.write(static_cast<uint64_t>(dod + 255), 9);
+         }
+         else if (dod >= -2047 && dod <= 2048)
+         {
+            writer.write(0xE, 4);
+            writer.write(static_cast<uint64_t>(dod + 2047), 12);
+         }
+         else
+         {
+            writer.write(0xF, 4);
+            writer.write(static_cast<uint64_t>(dod), 64);
+         }
+
+         delta = next_delta;
+      }
+
+      previous = bits;
+   }
+}
+
+void Gorilla::decodeDeltaOfDelta(const uint64_t* in, double* values, const size_t n)
+{
+   BitReader reader(in);
+   uint64_t previous = 0;
+   uint64_t delta = 0;
+
+   for (size_t i = 0; i < n; ++i)
+   {
+      if (i == 0)
+         previous = reader.read(64);
+      else if (i == 1)
+      {
+         delta = reader.read(64);
+         previous += delta;
+      }
+      else
+      {
+         int64_t dod = 0;
+         if (reader.bit())
+         {
+            if (!reader.bit())
+               dod = static_cast<int64_t>(reader.read(7)) - 63;
+            else if (!reader.bit())
+               dod = static_cast<int64_t>(reader.read(9)) - 255;
+            else if (!reader.bit())
+               dod = static_cast<int64_t>(reader.read(12)) - 2047;
+            else
+               dod = static_cast<int64_t>(reader.read(64));
+         }
+
+         delta += static_cast<uint64_t>(dod);
+         previous += delta;
+      }
+
+      values[i] = fromBits(previous);
+   }
+}
\ No newline at end of file
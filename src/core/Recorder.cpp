@@ -0,0 +1,52 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ascent/core/Recorder.h"
+
+using namespace asc;
+
+void Recorder::record(const double EPS)
+{
+   if (t_hist.empty())
+      return; // recording began after this step's time was stored, so this step can't be paired with a time
+
+   const size_t t_index = t_hist.size() - 1;
+
+   const double t = t_hist.back();
+
+   for (auto& p : groups)
+      p.second->record(t_index, t, EPS);
+}
+
+void Recorder::reserve(const size_t steps, const double dt)
+{
+   for (auto& p : groups)
+      p.second->reserve(steps, dt, max_reserve);
+}
+
+void Recorder::compress(const Codec codec)
+{
+   this->codec = codec;
+
+   for (auto& p : groups)
+      p.second->compress(codec);
+}
+
+size_t Recorder::size() const
+{
+   size_t n = 0;
+   for (auto& p : groups)
+      n += p.second->size();
+   return n;
+}
\ No newline at end of file
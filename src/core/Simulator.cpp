@@ -15,9 +15,13 @@
 #include "ascent/core/Simulator.h"
 
 #include "ascent/Module.h"
+#include "ascent/history/DelayBuffer.h"
 #include "ascent/integrators/RK4.h"
 
 #include <assert.h>
+#include <cstring>
+#include <sstream>
+#include <typeinfo>
 
 using namespace asc;
 
@@ -99,6 +103,15 @@ bool Simulator::run(const double dt_base, const double tmax)
    {
       event(t_end);
 
+      for (double sdt : track_samples)
+         sample(sdt);
+
+      if (sample())
+      {
+         for (DelayBase* delay : delays)
+            delay->align();
+      }
+
       if (tickfirst)
       {
          if (tick0 && track_time) // If the very first tick of the simulation.
@@ -106,6 +119,7 @@ bool Simulator::run(const double dt_base, const double tmax)
 
          changeTimeStep();
          report();
+         snapshot.publish(t);
 
          if (tick0) // tracker() must run after report(), but t_hist must be recorded before rpt(), thus tick0 checks are separated.
          {
@@ -116,6 +130,12 @@ bool Simulator::run(const double dt_base, const double tmax)
 
       update();
 
+      if (sample())
+      {
+         for (DelayBase* delay : delays)
+            delay->record();
+      }
+
       tickfirst = false;
 
       if (sample())
@@ -144,12 +164,17 @@ bool Simulator::run(const double dt_base, const double tmax)
             ticklast = true;
 
          report();
+         snapshot.publish(t);
 
          tracker();
 
+         if (telemetry)
+            telemetry->service(*this); // between full steps, so requests never race with module updates
+
          if (integrator->adaptive())
             adaptiveCalc();
 
+         changeIntegrator();
          changeTimeStep();
          changeEndTime();
 
@@ -157,6 +182,9 @@ bool Simulator::run(const double dt_base, const double tmax)
 
          if (ticklast)
          {
+            if (stream_writer && !stream_writer->flush())
+               setError("Streaming tracked data to file failed.");
+
             createFiles();
             break;
          }
@@ -167,13 +195,102 @@ bool Simulator::run(const double dt_base, const double tmax)
    
    directErase(true); // Specify that all DynamicMaps should use direct erasing since the simulation finished.
 
-   phase = Phase::setup;
+   setPhase(Phase::setup);
 
    if (error)
       return setError("Simulation was stopped due to an ERROR.");
    return true;
 }
 
+bool Simulator::checkpoint(std::ostream& stream)
+{
+   if (phase != Phase::setup && phase != Phase::report)
+      return setError("Checkpoints can only be saved between runs or from report().");
+
+   Archive archive;
+   serialize(archive);
+
+   stream.write(archive.data().data(), archive.data().size());
+   if (!stream)
+      return setError("The checkpoint could not be written.");
+   return true;
+}
+
+bool Simulator::restore(std::istream& stream)
+{
+   if (phase != Phase::setup)
+      return setError("Checkpoints can only be restored between runs.");
+
+   std::stringstream contents;
+   contents << stream.rdbuf();
+   Archive archive(contents.str());
+   return restore(archive);
+}
+
+bool Simulator::restore(Archive& archive)
+{
+   if (phase != Phase::setup)
+      return setError("Checkpoints can only be restored between runs.");
+
+   try
+   {
+      serialize(archive);
+   }
+   catch (const std::runtime_error& e)
+   {
+      return setError(string("The checkpoint could not be restored: ") + e.what());
+   }
+   return true;
+}
+
+void Simulator::serialize(Archive& archive)
+{
+   char magic[8];
+   memcpy(magic, "ASCCHKPT", 8);
+   archive.bytes(magic, 8);
+   if (memcmp(magic, "ASCCHKPT", 8) != 0)
+      throw runtime_error("not an Ascent checkpoint.");
+
+   uint32_t version = 1;
+   archive(version);
+   if (version != 1)
+      throw runtime_error("unsupported checkpoint version.");
+
+   std::string integrator_type = typeid(*integrator).name();
+   archive(integrator_type);
+   if (integrator_type != typeid(*integrator).name())
+      throw runtime_error("the checkpoint was saved with another integrator, set the same integrator before restoring.");
+   integrator->serializeClock(archive); // counts the steps of multistep initialization
+
+   archive(t, dt, dtp, t1, t_end, kpass, EPS, integrator_initialized, tick0, track_time, track_samples, t_hist);
+
+   bool record = (phase == Phase::report) && (!tickfirst || tick0); // saved from report(), before tracker() recorded the step
+   archive(record);
+
+   // Modules are matched by their construction order, other modules are referred to by their position in this order.
+   std::vector<Module*> order;
+   std::map<size_t, size_t> positions;
+   for (auto& p : modules)
+   {
+      positions[p.first] = order.size();
+      order.push_back(p.second);
+   }
+
+   const size_t n = archive.size(order.size());
+   if (n != order.size())
+      throw runtime_error("the checkpoint holds " + to_string(n) + " modules, but the simulator has " + to_string(order.size()) + ".");
+
+   for (Module* module : order)
+      module->serializeModule(archive, order, positions);
+
+   if (archive.loading() && record)
+   {
+      tracker();
+      tick0 = false;
+      setPhase(Phase::setup);
+   }
+}
+
 void Simulator::directErase(bool b)
 {
    modules.direct_erase = b;
@@ -190,7 +307,7 @@ void Simulator::directErase(bool b)
 
 void Simulator::setup(const double dt_base)
 {
-   phase = Phase::setup;
+   setPhase(Phase::setup);
 
    this->dt = dtp = dt_base; // sets base time step (dtp) and adjustable time step (dt)
    t1 = t + dt; // sets intended end time of next timestep
@@ -199,11 +316,14 @@ void Simulator::setup(const double dt_base)
    tickfirst = true;
    directErase(false);
    stop_simulation = false;
+
+   if (t_end > t)
+      recorder.reserve(static_cast<size_t>((t_end - t) / dtp) + 2, dtp); // preallocate column storage for the expected number of full steps, at each column's rate
 }
 
 void Simulator::init()
 {
-   phase = Phase::init;
+   setPhase(Phase::init);
    
    for (auto& p : inits)
    {
@@ -225,7 +345,7 @@ void Simulator::init()
 
 void Simulator::update()
 {
-   phase = Phase::update;
+   setPhase(Phase::update);
 
    for (auto& p : updates)
    {
@@ -244,13 +364,12 @@ void Simulator::update()
 
    updates.erase();
 
-   for (auto& p : updates)
-      p.second->update_run = false;
+   ++epoch; // every module is due again
 }
 
 void Simulator::postcalc()
 {
-   phase = Phase::postcalc;
+   setPhase(Phase::postcalc);
 
    for (auto& p : postcalcs)
    {
@@ -269,13 +388,12 @@ void Simulator::postcalc()
 
    postcalcs.erase();
 
-   for (auto& p : postcalcs)
-      p.second->postcalc_run = false;
+   ++epoch; // every module is due again
 }
 
 void Simulator::check()
 {
-   phase = Phase::check;
+   setPhase(Phase::check);
 
    for (auto& p : checks)
    {
@@ -294,8 +412,7 @@ void Simulator::check()
 
    checks.erase();
 
-   for (auto& p : checks)
-      p.second->check_run = false;
+   ++epoch; // every module is due again
 }
 
 void Simulator::chaiscript_event()
@@ -317,7 +434,7 @@ void Simulator::chaiscript_event()
 
 void Simulator::report()
 {
-   phase = Phase::report;
+   setPhase(Phase::report);
 
    for (auto& p : reports)
    {
@@ -336,13 +453,12 @@ void Simulator::report()
 
    reports.erase();
 
-   for (auto& p : reports)
-      p.second->report_run = false;
+   ++epoch; // every module is due again
 }
 
 void Simulator::reset()
 {
-   phase = Phase::reset;
+   setPhase(Phase::reset);
 
    for (auto& p : resets)
    {
@@ -361,16 +477,23 @@ void Simulator::reset()
 
    resets.erase();
 
-   for (auto& p : resets)
-      p.second->reset_run = false;
+   ++epoch; // every module is due again
 }
 
 void Simulator::tracker()
 {
-   phase = Phase::tracker;
+   setPhase(Phase::tracker);
+
+   recorder.record(EPS);
 
    for (auto& p : trackers)
       p.second->tracker();
+
+   for (auto& p : streamers)
+      p.second->streamRow();
+
+   for (auto& p : publishers)
+      p.second->shareRow();
 }
 
 void Simulator::propagateStates()
@@ -452,6 +575,19 @@ void Simulator::changeTimeStep()
    }
 }
 
+void Simulator::changeIntegrator()
+{
+   if (integrator_change)
+   {
+      integrator = std::move(integrator_change);
+
+      for (auto& p : propagate)
+         p.second->changeIntegrator();
+
+      integrator_initialized = false; // multistep and FSAL schemes must be seeded again from the current states
+   }
+}
+
 void Simulator::changeEndTime()
 {
    if (change_t_end)
@@ -515,6 +651,12 @@ bool Simulator::event(double t_event)
       return false;
 }
 
+void Simulator::compressHistory(const bool compress)
+{
+   t_hist.compress(compress ? Codec::delta_of_delta : Codec::none);
+   recorder.compress(compress ? Codec::xor_values : Codec::none);
+}
+
 void Simulator::integrationTolerance(double tolerance) // Set global adaptive step size tolerance
 {
    for (auto& p : modules)
@@ -531,6 +673,8 @@ bool Simulator::setError(const std::string& description)
 {
    error = true;
    error_descriptions.push_back(description);
+   if (stream_writer)
+      stream_writer->flush(); // keep the rows streamed up to the error
    if (print_errors)
       cerr << "ERROR: " + description << '\n';
    throw std::runtime_error(description.c_str());
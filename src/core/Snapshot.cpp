@@ -0,0 +1,78 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ascent/core/Snapshot.h"
+
+using namespace asc;
+using namespace std;
+
+void Snapshot::detach(const void* source)
+{
+   auto it = indices.find(source);
+   if (it == indices.end())
+      return;
+
+   for (Slot& slot : slots)
+      slot.values[it->second]->detach();
+}
+
+void Snapshot::publish(const double t)
+{
+   if (indices.empty())
+      return;
+
+   const size_t current = latest.load(memory_order_relaxed);
+   for (size_t k = 1; k < n_slots; ++k)
+   {
+      Slot& slot = slots[(current + k) % n_slots];
+
+      uint32_t unpinned = 0;
+      if (slot.state.compare_exchange_strong(unpinned, writing, memory_order_acquire))
+      {
+         for (auto& value : slot.values)
+            value->copy();
+         slot.t = t;
+         slot.step = ++published;
+
+         slot.state.fetch_sub(writing, memory_order_release); // readers that tried to pin the slot meanwhile hold their own count, so the flag is removed rather than the state reset
+         latest.store((current + k) % n_slots, memory_order_release);
+         return;
+      }
+   }
+
+   ++skipped;
+}
+
+Snapshot::View Snapshot::read()
+{
+   while (true)
+   {
+      Slot& slot = slots[latest.load(memory_order_acquire)];
+
+      const uint32_t state = slot.state.fetch_add(1, memory_order_acquire);
+      if (state & writing) // the writer claimed this slot after it was loaded as the latest, so a newer slot has been or is being published
+      {
+         slot.state.fetch_sub(1, memory_order_release);
+         continue;
+      }
+
+      if (slot.step == 0) // nothing published yet
+      {
+         slot.state.fetch_sub(1, memory_order_release);
+         return View();
+      }
+
+      return View(this, &slot);
+   }
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ascent/core/TrackRows.h"
+
+#include "ascent/core/Parameter.h"
+
+using namespace asc;
+
+TrackRows::TrackRows(const std::vector<ParameterBase*>& columns) : columns(columns), next(columns.size()), filled(columns.size())
+{
+   for (ParameterBase* column : columns)
+      lengths.push_back(column->length());
+}
+
+bool TrackRows::advance()
+{
+   const size_t n = columns.size();
+
+   for (size_t j = 0; j < n; ++j)
+   {
+      if (filled[j])
+         ++next[j]; // the sample was written in the previous row
+   }
+
+   bool found = false;
+   for (size_t j = 0; j < n; ++j)
+   {
+      if (next[j] < lengths[j])
+      {
+         const size_t index = columns[j]->tIndex(next[j]);
+         if (!found || index < t_index)
+            t_index = index;
+         found = true;
+      }
+   }
+
+   for (size_t j = 0; j < n; ++j)
+      filled[j] = found && next[j] < lengths[j] && columns[j]->tIndex(next[j]) == t_index;
+
+   return found;
+}
+
+bool TrackRows::aligned() const
+{
+   const size_t n = columns.size();
+   for (size_t j = 1; j < n; ++j)
+   {
+      if (lengths[j] != lengths[0])
+         return false;
+
+      for (size_t i = 0; i < lengths[j]; ++i)
+      {
+         if (columns[j]->tIndex(i) != columns[0]->tIndex(i))
+            return false;
+      }
+   }
+   return true;
+}
\ No newline at end of file
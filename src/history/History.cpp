@@ -23,7 +23,8 @@ History::History(const size_t sim, const size_t steps) : simulator(ModuleCore::g
    steps(steps), infinite(false),
    t(simulator.t), dt(simulator.dt)
 {
-
+   th.reserve(steps);
+   x.reserve(steps);
 }
 
 History::History(const size_t sim) : History(sim, 0)
@@ -44,8 +45,17 @@ void History::insert(const double value)
          simulator.setError("Attempted push_back on History when the current time is less than or equal to the last time recorded.");
    }
 
+   if (fitting)
+   {
+      if (parabolic_fit.drifted())
+         parabolic_fit.reset(th, x);
+      parabolic_fit.add(simulator.t, value);
+   }
+
    th.push_back(simulator.t);
    x.push_back(value);
+   statistics.push(value);
+   running_integral.push(th, x);
 }
 
 void History::push_back(const double value)
@@ -54,12 +64,36 @@ void History::push_back(const double value)
       insert(value);
    else if (steps > 0)
    {
+      th.reserve(steps); // allows number of steps to be lengthened during runtime
+      x.reserve(steps);
+
       while (x.size() >= steps) // allows number of steps to be lengthened or reduced during runtime
       {
-         th.erase(th.begin());
-         x.erase(x.begin());
+         statistics.pop(x.front());
+         running_integral.pop(th, x);
+         if (fitting)
+            parabolic_fit.remove(th.front(), x.front());
+         th.pop_front();
+         x.pop_front();
       }
 
+      if (statistics.drifted())
+         statistics.reset(x);
+      if (running_integral.drifted(x.size()))
+         running_integral.reset(th, x);
+
       insert(value);
    }
+}
+
+double History::extrapParabolicRecursive(const double xest, double& relative_error, const double forgetting)
+{
+   if (!fitting || forgetting != parabolic_fit.forgetting())
+   {
+      parabolic_fit.setForgetting(forgetting);
+      parabolic_fit.reset(th, x);
+      fitting = true;
+   }
+
+   return parabolic_fit.estimate(xest, relative_error);
 }
\ No newline at end of file
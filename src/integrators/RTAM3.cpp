@@ -29,6 +29,9 @@ void RTAM3::propagate()
          xd_1 = xd;
       }
 
+      if (0 == kpass)
+         ++init_step; // the prototype integrator counts steps in updateClock(), but each state must track its own derivative history
+
       initializer->propagate();
    }
    else
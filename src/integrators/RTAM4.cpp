@@ -35,6 +35,9 @@ void RTAM4::propagate()
          xd_1 = xd;
       }
 
+      if (0 == kpass)
+         ++init_step; // the prototype integrator counts steps in updateClock(), but each state must track its own derivative history
+
       initializer->propagate();
    }
    else
@@ -0,0 +1,70 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ascent/io/Archive.h"
+
+#include <cstring>
+
+using namespace asc;
+using namespace std;
+
+void Archive::bytes(void* data, const size_t n)
+{
+   if (restoring)
+   {
+      if (n > buffer.size() - pos)
+         throw runtime_error("Archive: unexpected end of the checkpoint.");
+      memcpy(data, buffer.data() + pos, n);
+      pos += n;
+   }
+   else
+      buffer.append(static_cast<const char*>(data), n);
+}
+
+size_t Archive::size(const size_t n)
+{
+   uint64_t length = n;
+   bytes(&length, sizeof(length));
+   return static_cast<size_t>(length);
+}
+
+size_t Archive::begin()
+{
+   if (restoring)
+   {
+      const size_t length = size(0);
+      if (length > buffer.size() - pos)
+         throw runtime_error("Archive: a block extends past the end of the checkpoint.");
+      return pos + length; // where the block ends
+   }
+
+   const size_t mark = buffer.size();
+   size(0); // the length is filled in by end()
+   return mark;
+}
+
+void Archive::end(const size_t mark)
+{
+   if (restoring)
+   {
+      if (pos > mark)
+         throw runtime_error("Archive: more was read than a block holds.");
+      pos = mark;
+   }
+   else
+   {
+      const uint64_t length = buffer.size() - mark - sizeof(uint64_t);
+      memcpy(&buffer[mark], &length, sizeof(length));
+   }
+}
\ No newline at end of file
@@ -0,0 +1,343 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "ascent/io/BinaryTrack.h"
+#include "ascent/io/Format.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace asc;
+using namespace asc::BinaryTrack;
+using namespace std;
+
+namespace
+{
+   const char magic[8] = { 'A', 'S', 'C', 'T', 'R', 'A', 'C', 'K' };
+   const uint32_t version = 1;
+
+   size_t align8(const size_t n) { return (n + 7) & ~size_t(7); }
+
+   template <typename T>
+   void put(std::string& header, const T& x)
+   {
+      header.append(reinterpret_cast<const char*>(&x), sizeof(T));
+   }
+
+   template <typename T>
+   T get(const char*& p, const char* end)
+   {
+      if (p + sizeof(T) > end)
+         throw runtime_error("BinaryTrack: truncated header.");
+      T x;
+      memcpy(&x, p, sizeof(T));
+      p += sizeof(T);
+      return x;
+   }
+}
+
+size_t BinaryTrack::scalarSize(const Scalar scalar)
+{
+   switch (scalar)
+   {
+   case Scalar::float64: return 8;
+   case Scalar::float32: return 4;
+   case Scalar::int32: return 4;
+   case Scalar::uint64: return 8;
+   case Scalar::boolean: return 1;
+   }
+   return 0;
+}
+
+void BinaryTrack::write(std::ostream& stream, const std::vector<Source>& sources)
+{
+   size_t header_size = sizeof(magic) + 2 * sizeof(uint32_t);
+   for (const Source& source : sources)
+      header_size += sizeof(uint32_t) + source.name.size() + 2 * sizeof(uint8_t) + 2 * sizeof(uint32_t) + 2 * sizeof(uint64_t);
+
+   string header;
+   header.append(magic, sizeof(magic));
+   put(header, version);
+   put(header, static_cast<uint32_t>(sources.size()));
+
+   vector<uint64_t> offsets;
+   uint64_t offset = align8(header_size);
+   for (const Source& source : sources)
+   {
+      put(header, static_cast<uint32_t>(source.name.size()));
+      header += source.name;
+      put(header, static_cast<uint8_t>(source.layout.scalar));
+      put(header, source.flags);
+      put(header, source.layout.rows);
+      put(header, source.layout.cols);
+      put(header, source.length);
+      put(header, offset);
+
+      offsets.push_back(offset);
+      offset = align8(offset + source.length * source.layout.bytes());
+   }
+
+   stream.write(header.data(), header.size());
+
+   const char padding[8] = {};
+   uint64_t position = header.size();
+   size_t n = sources.size();
+   for (size_t i = 0; i < n; ++i)
+   {
+      stream.write(padding, offsets[i] - position);
+      sources[i].write(stream);
+      position = offsets[i] + sources[i].length * sources[i].layout.bytes();
+   }
+   stream.write(padding, align8(position) - position);
+}
+
+double File::Column::value(const size_t i, const size_t element) const
+{
+   const size_t k = i * layout.elements() + element;
+   switch (layout.scalar)
+   {
+   case Scalar::float64: return reinterpret_cast<const double*>(data)[k];
+   case Scalar::float32: return reinterpret_cast<const float*>(data)[k];
+   case Scalar::int32: return reinterpret_cast<const int32_t*>(data)[k];
+   case Scalar::uint64: return static_cast<double>(reinterpret_cast<const uint64_t*>(data)[k]);
+   case Scalar::boolean: return reinterpret_cast<const uint8_t*>(data)[k];
+   }
+   return 0.0;
+}
+
+File::File(const std::string& filename)
+{
+#ifndef _WIN32
+   int fd = open(filename.c_str(), O_RDONLY);
+   if (fd < 0)
+      throw runtime_error("BinaryTrack: file " + filename + " could not be opened.");
+
+   struct stat info;
+   if (fstat(fd, &info) == 0 && info.st_size > 0)
+   {
+      void* p = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p != MAP_FAILED)
+      {
+         mapping = p;
+         begin = static_cast<const char*>(p);
+         size = static_cast<size_t>(info.st_size);
+      }
+   }
+   close(fd);
+#endif
+
+   if (!mapping) // read the whole file instead
+   {
+      ifstream file(filename, ios::binary);
+      if (!file)
+         throw runtime_error("BinaryTrack: file " + filename + " could not be opened.");
+
+      buffer.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+      begin = buffer.data();
+      size = buffer.size();
+   }
+
+   try
+   {
+      parse();
+   }
+   catch (...)
+   {
+#ifndef _WIN32
+      if (mapping)
+         munmap(mapping, size);
+#endif
+      throw;
+   }
+}
+
+File::~File()
+{
+#ifndef _WIN32
+   if (mapping)
+      munmap(mapping, size);
+#endif
+}
+
+void File::parse()
+{
+   const char* end = begin + size;
+   const char* p = begin;
+
+   if (size < sizeof(magic) || memcmp(p, magic, sizeof(magic)) != 0)
+      throw runtime_error("BinaryTrack: not an Ascent binary track file.");
+   p += sizeof(magic);
+
+   if (get<uint32_t>(p, end) != version)
+      throw runtime_error("BinaryTrack: unsupported version.");
+
+   const uint32_t n = get<uint32_t>(p, end);
+   for (uint32_t i = 0; i < n; ++i)
+   {
+      Column column;
+
+      const uint32_t name_length = get<uint32_t>(p, end);
+      if (p + name_length > end)
+         throw runtime_error("BinaryTrack: truncated header.");
+      column.name.assign(p, name_length);
+      p += name_length;
+
+      column.layout.supported = true;
+      column.layout.scalar = static_cast<Scalar>(get<uint8_t>(p, end));
+      if (scalarSize(column.layout.scalar) == 0)
+         throw runtime_error("BinaryTrack: unknown scalar type in column " + column.name + ".");
+      column.flags = get<uint8_t>(p, end);
+      column.layout.rows = get<uint32_t>(p, end);
+      column.layout.cols = get<uint32_t>(p, end);
+      column.length = get<uint64_t>(p, end);
+
+      const uint64_t offset = get<uint64_t>(p, end);
+      const size_t bytes = column.layout.bytes();
+      if (bytes == 0)
+         throw runtime_error("BinaryTrack: column " + column.name + " has no elements.");
+      if (offset > size || column.length > (size - offset) / bytes) // written so that corrupt lengths and offsets can't overflow
+         throw runtime_error("BinaryTrack: column " + column.name + " extends past the end of the file.");
+      column.data = begin + offset;
+
+      columns.push_back(column);
+   }
+}
+
+const File::Column* File::find(const std::string& name) const
+{
+   for (const Column& column : columns)
+   {
+      if (column.name == name)
+         return &column;
+   }
+   return nullptr;
+}
+
+namespace
+{
+   template <typename T>
+   T load(const char* data, const size_t k) // data may not be aligned for T
+   {
+      T x;
+      memcpy(&x, data + k * sizeof(T), sizeof(T));
+      return x;
+   }
+
+   struct Append
+   {
+      template <typename T>
+      void operator()(string& out, const T x) const { Format::append(out, x); }
+   };
+
+   struct AppendJson
+   {
+      template <typename T>
+      void operator()(string& out, const T x) const { Format::appendJson(out, x); }
+   };
+
+   template <typename Appender>
+   void printElements(string& out, const Layout& layout, const char* value, const Appender append)
+   {
+      const size_t n = layout.elements();
+      for (size_t k = 0; k < n; ++k)
+      {
+         switch (layout.scalar)
+         {
+         case Scalar::float64: append(out, load<double>(value, k)); break;
+         case Scalar::float32: append(out, load<float>(value, k)); break;
+         case Scalar::int32: append(out, load<int>(value, k)); break;
+         case Scalar::uint64: append(out, load<uint64_t>(value, k)); break;
+         case Scalar::boolean: append(out, value[k] != 0); break;
+         }
+
+         if (k < n - 1) // not the last element
+            out += ',';
+      }
+   }
+}
+
+void BinaryTrack::print(std::string& out, const Layout& layout, const char* value) { printElements(out, layout, value, Append()); }
+
+void BinaryTrack::printJson(std::string& out, const Layout& layout, const char* value) { printElements(out, layout, value, AppendJson()); }
+
+void File::toCSV(std::ostream& stream) const
+{
+   size_t rows = 0;
+   size_t n = columns.size();
+   for (size_t j = 0; j < n; ++j)
+   {
+      stream << columns[j].name;
+      if (j < n - 1)
+         stream << ",";
+      rows = max(rows, static_cast<size_t>(columns[j].length));
+   }
+   stream << '\n';
+
+   string row; // reused for every row
+   for (size_t i = 0; i < rows; ++i)
+   {
+      row.clear();
+      for (size_t j = 0; j < n; ++j)
+      {
+         if (i < columns[j].length)
+            print(row, columns[j].layout, columns[j].data + i * columns[j].layout.bytes());
+         if (j < n - 1)
+            row += ',';
+      }
+      row += '\n';
+      stream.write(row.data(), row.size());
+   }
+}
+
+void File::toJSON(std::ostream& stream) const
+{
+   stream << "{";
+   size_t n = columns.size();
+   for (size_t j = 0; j < n; ++j)
+   {
+      const Column& column = columns[j];
+      string value;
+      Format::appendJson(value, column.name);
+      value += ":[";
+      stream.write(value.data(), value.size());
+
+      const bool array = column.layout.elements() > 1;
+      for (size_t i = 0; i < column.length; ++i)
+      {
+         value.clear();
+         if (array)
+            value += '[';
+         printJson(value, column.layout, column.data + i * column.layout.bytes());
+         if (array)
+            value += ']';
+         if (i < column.length - 1)
+            value += ',';
+         stream.write(value.data(), value.size());
+      }
+
+      stream << "]";
+      if (j < n - 1)
+         stream << ",";
+   }
+   stream << "}";
+}
\ No newline at end of file
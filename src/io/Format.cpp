@@ -0,0 +1,497 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "ascent/io/Format.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+using namespace asc;
+
+// Grisu2 shortest round trip conversion, after Florian Loitsch, "Printing Floating-Point Numbers Quickly and Accurately with Integers" (PLDI 2010),
+// and the public domain implementation in nlohmann/json (dtoa_impl). The output always reads back as the original value and is, in almost all cases, the shortest such output.
+
+namespace
+{
+   // A floating point number f * 2^e with a 64 bit significand.
+   struct DiyFp
+   {
+      static constexpr int significand_size = 64;
+
+      uint64_t f = 0;
+      int e = 0;
+
+      constexpr DiyFp(const uint64_t f, const int e) : f(f), e(e) {}
+
+      static DiyFp sub(const DiyFp& x, const DiyFp& y) { return DiyFp(x.f - y.f, x.e); } // requires x.e == y.e and x.f >= y.f
+
+      // The rounded upper 64 bits of the 128 bit product x.f * y.f.
+      static DiyFp mul(const DiyFp& x, const DiyFp& y)
+      {
+         const uint64_t u_lo = x.f & 0xFFFFFFFFu;
+         const uint64_t u_hi = x.f >> 32u;
+         const uint64_t v_lo = y.f & 0xFFFFFFFFu;
+         const uint64_t v_hi = y.f >> 32u;
+
+         const uint64_t p0 = u_lo * v_lo;
+         const uint64_t p1 = u_lo * v_hi;
+         const uint64_t p2 = u_hi * v_lo;
+         const uint64_t p3 = u_hi * v_hi;
+
+         uint64_t Q = (p0 >> 32u) + (p1 & 0xFFFFFFFFu) + (p2 & 0xFFFFFFFFu);
+         Q += uint64_t{ 1 } << 31u; // round up
+
+         const uint64_t h = p3 + (p2 >> 32u) + (p1 >> 32u) + (Q >> 32u);
+         return DiyFp(h, x.e + y.e + 64);
+      }
+
+      static DiyFp normalize(DiyFp x)
+      {
+         while ((x.f >> 63u) == 0)
+         {
+            x.f <<= 1u;
+            x.e--;
+         }
+         return x;
+      }
+
+      static DiyFp normalizeTo(const DiyFp& x, const int target_exponent)
+      {
+         const int delta = x.e - target_exponent;
+         return DiyFp(x.f << delta, target_exponent);
+      }
+   };
+
+   // The normalized value v and the normalized boundaries m- and m+ of the interval of numbers that round to v.
+   struct Boundaries
+   {
+      DiyFp w;
+      DiyFp minus;
+      DiyFp plus;
+   };
+
+   template <typename FloatType>
+   Boundaries computeBoundaries(const FloatType value)
+   {
+      constexpr int precision = std::numeric_limits<FloatType>::digits; // including the hidden bit
+      constexpr int bias = std::numeric_limits<FloatType>::max_exponent - 1 + (precision - 1);
+      constexpr int min_exponent = 1 - bias;
+      constexpr uint64_t hidden_bit = uint64_t{ 1 } << (precision - 1);
+
+      typedef typename std::conditional<precision == 24, uint32_t, uint64_t>::type Bits;
+
+      Bits bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      const uint64_t E = bits >> (precision - 1);
+      const uint64_t F = bits & (hidden_bit - 1);
+
+      const bool is_denormal = E == 0;
+      const DiyFp v = is_denormal ? DiyFp(F, min_exponent) : DiyFp(F + hidden_bit, static_cast<int>(E) - bias);
+
+      // The lower boundary is closer when the significand is a power of two (except for the smallest normal exponent).
+      const bool lower_boundary_is_closer = F == 0 && E > 1;
+      const DiyFp m_plus = DiyFp(2 * v.f + 1, v.e - 1);
+      const DiyFp m_minus = lower_boundary_is_closer ? DiyFp(4 * v.f - 1, v.e - 2) : DiyFp(2 * v.f - 1, v.e - 1);
+
+      const DiyFp w_plus = DiyFp::normalize(m_plus);
+      const DiyFp w_minus = DiyFp::normalizeTo(m_minus, w_plus.e);
+
+      return { DiyFp::normalize(v), w_minus, w_plus };
+   }
+
+   // The cached power c = f * 2^e ~= 10^k is chosen so that the product with w has a binary exponent in [alpha, gamma],
+   // which lets the digit generation split the scaled value into 32 bit integral and 64 bit fractional parts.
+   constexpr int alpha = -60;
+   constexpr int gamma = -32;
+
+   struct CachedPower
+   {
+      uint64_t f;
+      int e;
+      int k;
+   };
+
+   CachedPower cachedPower(const int e)
+   {
+      constexpr int min_decimal_exponent = -300;
+      constexpr int decimal_exponent_step = 8;
+
+      static constexpr CachedPower powers[] =
+      {
+         { 0xAB70FE17C79AC6CA, -1060, -300 },
+         { 0xFF77B1FCBEBCDC4F, -1034, -292 },
+         { 0xBE5691EF416BD60C, -1007, -284 },
+         { 0x8DD01FAD907FFC3C, -980, -276 },
+         { 0xD3515C2831559A83, -954, -268 },
+         { 0x9D71AC8FADA6C9B5, -927, -260 },
+         { 0xEA9C227723EE8BCB, -901, -252 },
+         { 0xAECC49914078536D, -874, -244 },
+         { 0x823C12795DB6CE57, -847, -236 },
+         { 0xC21094364DFB5637, -821, -228 },
+         { 0x9096EA6F3848984F, -794, -220 },
+         { 0xD77485CB25823AC7, -768, -212 },
+         { 0xA086CFCD97BF97F4, -741, -204 },
+         { 0xEF340A98172AACE5, -715, -196 },
+         { 0xB23867FB2A35B28E, -688, -188 },
+         { 0x84C8D4DFD2C63F3B, -661, -180 },
+         { 0xC5DD44271AD3CDBA, -635, -172 },
+         { 0x936B9FCEBB25C996, -608, -164 },
+         { 0xDBAC6C247D62A584, -582, -156 },
+         { 0xA3AB66580D5FDAF6, -555, -148 },
+         { 0xF3E2F893DEC3F126, -529, -140 },
+         { 0xB5B5ADA8AAFF80B8, -502, -132 },
+         { 0x87625F056C7C4A8B, -475, -124 },
+         { 0xC9BCFF6034C13053, -449, -116 },
+         { 0x964E858C91BA2655, -422, -108 },
+         { 0xDFF9772470297EBD, -396, -100 },
+         { 0xA6DFBD9FB8E5B88F, -369, -92 },
+         { 0xF8A95FCF88747D94, -343, -84 },
+         { 0xB94470938FA89BCF, -316, -76 },
+         { 0x8A08F0F8BF0F156B, -289, -68 },
+         { 0xCDB02555653131B6, -263, -60 },
+         { 0x993FE2C6D07B7FAC, -236, -52 },
+         { 0xE45C10C42A2B3B06, -210, -44 },
+         { 0xAA242499697392D3, -183, -36 },
+         { 0xFD87B5F28300CA0E, -157, -28 },
+         { 0xBCE5086492111AEB, -130, -20 },
+         { 0x8CBCCC096F5088CC, -103, -12 },
+         { 0xD1B71758E219652C, -77, -4 },
+         { 0x9C40000000000000, -50, 4 },
+         { 0xE8D4A51000000000, -24, 12 },
+         { 0xAD78EBC5AC620000, 3, 20 },
+         { 0x813F3978F8940984, 30, 28 },
+         { 0xC097CE7BC90715B3, 56, 36 },
+         { 0x8F7E32CE7BEA5C70, 83, 44 },
+         { 0xD5D238A4ABE98068, 109, 52 },
+         { 0x9F4F2726179A2245, 136, 60 },
+         { 0xED63A231D4C4FB27, 162, 68 },
+         { 0xB0DE65388CC8ADA8, 189, 76 },
+         { 0x83C7088E1AAB65DB, 216, 84 },
+         { 0xC45D1DF942711D9A, 242, 92 },
+         { 0x924D692CA61BE758, 269, 100 },
+         { 0xDA01EE641A708DEA, 295, 108 },
+         { 0xA26DA3999AEF774A, 322, 116 },
+         { 0xF209787BB47D6B85, 348, 124 },
+         { 0xB454E4A179DD1877, 375, 132 },
+         { 0x865B86925B9BC5C2, 402, 140 },
+         { 0xC83553C5C8965D3D, 428, 148 },
+         { 0x952AB45CFA97A0B3, 455, 156 },
+         { 0xDE469FBD99A05FE3, 481, 164 },
+         { 0xA59BC234DB398C25, 508, 172 },
+         { 0xF6C69A72A3989F5C, 534, 180 },
+         { 0xB7DCBF5354E9BECE, 561, 188 },
+         { 0x88FCF317F22241E2, 588, 196 },
+         { 0xCC20CE9BD35C78A5, 614, 204 },
+         { 0x98165AF37B2153DF, 641, 212 },
+         { 0xE2A0B5DC971F303A, 667, 220 },
+         { 0xA8D9D1535CE3B396, 694, 228 },
+         { 0xFB9B7CD9A4A7443C, 720, 236 },
+         { 0xBB764C4CA7A44410, 747, 244 },
+         { 0x8BAB8EEFB6409C1A, 774, 252 },
+         { 0xD01FEF10A657842C, 800, 260 },
+         { 0x9B10A4E5E9913129, 827, 268 },
+         { 0xE7109BFBA19C0C9D, 853, 276 },
+         { 0xAC2820D9623BF429, 880, 284 },
+         { 0x80444B5E7AA7CF85, 907, 292 },
+         { 0xBF21E44003ACDD2D, 933, 300 },
+         { 0x8E679C2F5E44FF8F, 960, 308 },
+         { 0xD433179D9C8CB841, 986, 316 },
+         { 0x9E19DB92B4E31BA9, 1013, 324 },
+      };
+
+      // 78913 / 2^18 approximates log10(2), k is the smallest power of ten with alpha <= e_c + e + 64
+      const int f = alpha - e - 1;
+      const int k = (f * 78913) / (1 << 18) + static_cast<int>(f > 0);
+
+      const int index = (-min_decimal_exponent + k + (decimal_exponent_step - 1)) / decimal_exponent_step;
+      return powers[index];
+   }
+
+   // The largest power of ten <= n (n < 10^10), returns its number of digits.
+   int findLargestPow10(const uint32_t n, uint32_t& pow10)
+   {
+      if (n >= 1000000000) { pow10 = 1000000000; return 10; }
+      if (n >= 100000000) { pow10 = 100000000; return 9; }
+      if (n >= 10000000) { pow10 = 10000000; return 8; }
+      if (n >= 1000000) { pow10 = 1000000; return 7; }
+      if (n >= 100000) { pow10 = 100000; return 6; }
+      if (n >= 10000) { pow10 = 10000; return 5; }
+      if (n >= 1000) { pow10 = 1000; return 4; }
+      if (n >= 100) { pow10 = 100; return 3; }
+      if (n >= 10) { pow10 = 10; return 2; }
+      pow10 = 1;
+      return 1;
+   }
+
+   // Move the last digit towards the exact value w while the result stays within the rounding interval.
+   void grisu2Round(char* buf, const int len, const uint64_t dist, const uint64_t delta, uint64_t rest, const uint64_t ten_k)
+   {
+      while (rest < dist && delta - rest >= ten_k && (rest + ten_k < dist || dist - rest > rest + ten_k - dist))
+      {
+         buf[len - 1]--;
+         rest += ten_k;
+      }
+   }
+
+   // Generate the shortest digits of a value in the interval (M-, M+), as close to w as possible.
+   void grisu2DigitGen(char* buffer, int& length, int& decimal_exponent, const DiyFp M_minus, const DiyFp w, const DiyFp M_plus)
+   {
+      uint64_t delta = DiyFp::sub(M_plus, M_minus).f;
+      uint64_t dist = DiyFp::sub(M_plus, w).f;
+
+      const DiyFp one(uint64_t{ 1 } << -M_plus.e, M_plus.e);
+
+      auto p1 = static_cast<uint32_t>(M_plus.f >> -one.e); // integral part, < 2^32 since e >= -60
+      uint64_t p2 = M_plus.f & (one.f - 1); // fractional part
+
+      uint32_t pow10;
+      const int k = findLargestPow10(p1, pow10);
+
+      int n = k;
+      while (n > 0)
+      {
+         const uint32_t d = p1 / pow10;
+         const uint32_t r = p1 % pow10;
+         buffer[length++] = static_cast<char>('0' + d);
+         p1 = r;
+         n--;
+
+         const uint64_t rest = (uint64_t{ p1 } << -one.e) + p2;
+         if (rest <= delta)
+         {
+            decimal_exponent += n;
+            grisu2Round(buffer, length, dist, delta, rest, uint64_t{ pow10 } << -one.e);
+            return;
+         }
+
+         pow10 /= 10;
+      }
+
+      int m = 0;
+      for (;;)
+      {
+         p2 *= 10;
+         const uint64_t d = p2 >> -one.e;
+         const uint64_t r = p2 & (one.f - 1);
+         buffer[length++] = static_cast<char>('0' + d);
+         p2 = r;
+         m++;
+
+         delta *= 10;
+         dist *= 10;
+         if (p2 <= delta)
+            break;
+      }
+
+      decimal_exponent -= m;
+      grisu2Round(buffer, length, dist, delta, p2, one.f);
+   }
+
+   // Shortest digits of a positive finite value, value = digits * 10^decimal_exponent.
+   template <typename FloatType>
+   void grisu2(char* buffer, int& length, int& decimal_exponent, const FloatType value)
+   {
+      const Boundaries w = computeBoundaries(value);
+
+      const CachedPower cached = cachedPower(w.plus.e);
+      const DiyFp c_minus_k(cached.f, cached.e);
+
+      const DiyFp w_scaled = DiyFp::mul(w.w, c_minus_k);
+      const DiyFp w_minus = DiyFp::mul(w.minus, c_minus_k);
+      const DiyFp w_plus = DiyFp::mul(w.plus, c_minus_k);
+
+      // The products are only accurate to 1 ulp, so the interval is narrowed by 1 ulp on each side to stay within it.
+      const DiyFp M_minus(w_minus.f + 1, w_minus.e);
+      const DiyFp M_plus(w_plus.f - 1, w_plus.e);
+
+      length = 0;
+      decimal_exponent = -cached.k;
+      grisu2DigitGen(buffer, length, decimal_exponent, M_minus, w_scaled, M_plus);
+   }
+
+   char* appendExponent(char* buf, int e)
+   {
+      if (e < 0)
+      {
+         e = -e;
+         *buf++ = '-';
+      }
+      else
+         *buf++ = '+';
+
+      const auto k = static_cast<uint32_t>(e);
+      if (k < 10)
+      {
+         *buf++ = '0'; // at least two digits, as printf writes exponents
+         *buf++ = static_cast<char>('0' + k);
+      }
+      else if (k < 100)
+      {
+         *buf++ = static_cast<char>('0' + k / 10);
+         *buf++ = static_cast<char>('0' + k % 10);
+      }
+      else
+      {
+         *buf++ = static_cast<char>('0' + k / 100);
+         *buf++ = static_cast<char>('0' + (k / 10) % 10);
+         *buf++ = static_cast<char>('0' + k % 10);
+      }
+
+      return buf;
+   }
+
+   // Lay out the digits buf[0, length) * 10^decimal_exponent in place, in fixed notation for moderate exponents and scientific notation otherwise.
+   char* formatDigits(char* buf, const int length, const int decimal_exponent)
+   {
+      const int k = length;
+      const int n = length + decimal_exponent; // position of the decimal point, value = 0.d1d2...dk * 10^n
+
+      constexpr int min_exp = -4;
+      constexpr int max_exp = 16;
+
+      if (k <= n && n <= max_exp) // integer, digits followed by zeros: 1234e7 -> 12340000000
+      {
+         std::memset(buf + k, '0', static_cast<size_t>(n - k));
+         return buf + n;
+      }
+
+      if (0 < n && n <= max_exp) // decimal point inside the digits: 1234e-2 -> 12.34
+      {
+         std::memmove(buf + (n + 1), buf + n, static_cast<size_t>(k - n));
+         buf[n] = '.';
+         return buf + (k + 1);
+      }
+
+      if (min_exp < n && n <= 0) // leading zeros: 1234e-6 -> 0.001234
+      {
+         std::memmove(buf + (2 + -n), buf, static_cast<size_t>(k));
+         buf[0] = '0';
+         buf[1] = '.';
+         std::memset(buf + 2, '0', static_cast<size_t>(-n));
+         return buf + (2 + (-n) + k);
+      }
+
+      if (k == 1) // 1e30
+         buf += 1;
+      else // 1.234e30
+      {
+         std::memmove(buf + 2, buf + 1, static_cast<size_t>(k - 1));
+         buf[1] = '.';
+         buf += 1 + k;
+      }
+
+      *buf++ = 'e';
+      return appendExponent(buf, n - 1);
+   }
+
+   template <typename FloatType>
+   char* writeFloat(char* first, FloatType x)
+   {
+      if (std::isnan(x))
+      {
+         std::memcpy(first, "nan", 3);
+         return first + 3;
+      }
+
+      if (std::signbit(x))
+      {
+         x = -x;
+         *first++ = '-';
+      }
+
+      if (std::isinf(x))
+      {
+         std::memcpy(first, "inf", 3);
+         return first + 3;
+      }
+
+      if (x == 0)
+      {
+         *first++ = '0';
+         return first;
+      }
+
+      int length = 0;
+      int decimal_exponent = 0;
+      grisu2(first, length, decimal_exponent, x);
+      return formatDigits(first, length, decimal_exponent);
+   }
+}
+
+char* Format::write(char* first, const double x)
+{
+   return writeFloat(first, x);
+}
+
+char* Format::write(char* first, const float x)
+{
+   // Digits are generated for the float itself, so 0.1f is written as 0.1 rather than as the double 0.100000001490116...
+   return writeFloat(first, x);
+}
+
+char* Format::write(char* first, const uint64_t x)
+{
+   char digits[20];
+   char* p = digits + sizeof(digits);
+   uint64_t v = x;
+   do
+   {
+      *--p = static_cast<char>('0' + v % 10);
+      v /= 10;
+   } while (v > 0);
+
+   const size_t n = static_cast<size_t>(digits + sizeof(digits) - p);
+   std::memcpy(first, p, n);
+   return first + n;
+}
+
+void Format::appendJson(std::string& out, const std::string& x)
+{
+   static const char hex[] = "0123456789abcdef";
+
+   out += '"';
+   for (const char c : x)
+   {
+      switch (c)
+      {
+      case '"': out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      default:
+         if (static_cast<unsigned char>(c) < 0x20) // other control characters
+         {
+            out += "\\u00";
+            out += hex[(c >> 4) & 0xF];
+            out += hex[c & 0xF];
+         }
+         else
+            out += c;
+      }
+   }
+   out += '"';
+}
+
+char* Format::write(char* first, const int64_t x)
+{
+   if (x < 0)
+   {
+      *first++ = '-';
+      return write(first, uint64_t{ 0 } - static_cast<uint64_t>(x)); // well defined for the most negative value
+   }
+   return write(first, static_cast<uint64_t>(x));
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "ascent/io/JsonWriter.h"
+
+using namespace asc;
+
+JsonWriter::JsonWriter(std::string& out) : out(out) {}
+
+JsonWriter::JsonWriter(std::ostream& stream, const size_t buffer_size) : out(buffer), stream(&stream), buffer_size(buffer_size)
+{
+   buffer.reserve(buffer_size + 1024);
+}
+
+JsonWriter::~JsonWriter()
+{
+   flush();
+}
+
+void JsonWriter::separate()
+{
+   if (stream && buffer.size() >= buffer_size)
+      flush();
+
+   if (after_key)
+      after_key = false;
+   else if (!first.empty())
+   {
+      if (!first.back())
+         out += ',';
+      first.back() = false;
+   }
+}
+
+void JsonWriter::beginObject()
+{
+   separate();
+   out += '{';
+   first.push_back(true);
+}
+
+void JsonWriter::endObject()
+{
+   out += '}';
+   first.pop_back();
+}
+
+void JsonWriter::beginArray()
+{
+   separate();
+   out += '[';
+   first.push_back(true);
+}
+
+void JsonWriter::endArray()
+{
+   out += ']';
+   first.pop_back();
+}
+
+void JsonWriter::key(const std::string& name)
+{
+   separate();
+   Format::appendJson(out, name);
+   out += ':';
+   after_key = true;
+}
+
+std::string& JsonWriter::value()
+{
+   separate();
+   return out;
+}
+
+void JsonWriter::flush()
+{
+   if (stream && !buffer.empty())
+   {
+      stream->write(buffer.data(), buffer.size());
+      buffer.clear();
+   }
+}
\ No newline at end of file
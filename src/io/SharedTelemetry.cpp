@@ -0,0 +1,323 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ascent/io/SharedTelemetry.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace asc;
+using namespace asc::SharedTelemetry;
+using namespace std;
+
+#if ATOMIC_LLONG_LOCK_FREE != 2
+#error "SharedTelemetry requires lock-free 64 bit atomics"
+#endif
+
+namespace
+{
+   const char magic[8] = { 'A', 'S', 'C', 'T', 'E', 'L', 'E', 'M' };
+
+   typedef std::atomic<uint64_t> Word;
+
+   size_t slotsOffset(const uint32_t columns)
+   {
+      const size_t offset = sizeof(Header) + columns * sizeof(ColumnInfo);
+      return (offset + 63) & ~size_t(63); // slots start on a cache line
+   }
+
+   size_t slotWords(const uint32_t frame_words) { return 1 + frame_words; } // sequence, then the frame
+
+   const Word* slot(const Header* header, const uint64_t index)
+   {
+      const char* base = reinterpret_cast<const char*>(header) + slotsOffset(header->columns);
+      return reinterpret_cast<const Word*>(base) + (index % header->capacity) * slotWords(header->frame_words);
+   }
+
+   Word* slot(Header* header, const uint64_t index) { return const_cast<Word*>(slot(static_cast<const Header*>(header), index)); }
+
+   uint64_t toWord(const double x)
+   {
+      uint64_t w;
+      memcpy(&w, &x, sizeof(w));
+      return w;
+   }
+
+   double toDouble(const uint64_t w)
+   {
+      double x;
+      memcpy(&x, &w, sizeof(x));
+      return x;
+   }
+
+   double element(const BinaryTrack::Layout& layout, const char* value, const size_t k)
+   {
+      switch (layout.scalar)
+      {
+      case BinaryTrack::Scalar::float64: { double x; memcpy(&x, value + k * sizeof(double), sizeof(double)); return x; }
+      case BinaryTrack::Scalar::float32: { float x; memcpy(&x, value + k * sizeof(float), sizeof(float)); return x; }
+      case BinaryTrack::Scalar::int32: { int32_t x; memcpy(&x, value + k * sizeof(int32_t), sizeof(int32_t)); return x; }
+      case BinaryTrack::Scalar::uint64: { uint64_t x; memcpy(&x, value + k * sizeof(uint64_t), sizeof(uint64_t)); return static_cast<double>(x); }
+      case BinaryTrack::Scalar::boolean: return value[k] ? 1.0 : 0.0;
+      }
+      return 0.0;
+   }
+}
+
+Writer::~Writer()
+{
+   close();
+}
+
+Reader::~Reader()
+{
+   close();
+}
+
+const ColumnInfo* Reader::find(const std::string& name) const
+{
+   for (auto& column : columns)
+   {
+      if (name == column.name)
+         return &column;
+   }
+   return nullptr;
+}
+
+void Writer::write(const double t, const std::vector<const void*>& values)
+{
+   if (!header)
+      return;
+
+   const uint64_t n = frames;
+   Word* s = slot(header, n);
+   Word* words = s + 1;
+
+   s[0].store(2 * n + 1, memory_order_relaxed); // being written
+   atomic_thread_fence(memory_order_release); // the odd sequence is visible before any of the frame's words
+
+   words[0].store(toWord(t), memory_order_relaxed);
+   size_t w = 1;
+   const size_t n_columns = columns.size();
+   for (size_t j = 0; j < n_columns; ++j)
+   {
+      const BinaryTrack::Layout& layout = columns[j].layout;
+      const char* value = static_cast<const char*>(values[j]);
+      const size_t elements = layout.elements();
+      for (size_t k = 0; k < elements; ++k)
+         words[w++].store(toWord(element(layout, value, k)), memory_order_relaxed);
+   }
+
+   s[0].store(2 * n + 2, memory_order_release); // complete
+   frames = n + 1;
+   header->frames.store(frames, memory_order_release);
+}
+
+bool Reader::read(const uint64_t index, Frame& frame) const
+{
+   if (!header)
+      return false;
+
+   const uint64_t published = header->frames.load(memory_order_acquire);
+   if (index >= published || published - index > header->capacity)
+      return false;
+
+   const Word* s = slot(header, index);
+   const Word* words = s + 1;
+   const uint64_t expected = 2 * index + 2;
+
+   if (s[0].load(memory_order_acquire) != expected)
+      return false;
+
+   const size_t n = header->frame_words;
+   frame.index = index;
+   frame.t = toDouble(words[0].load(memory_order_relaxed));
+   frame.values.resize(n - 1);
+   for (size_t w = 1; w < n; ++w)
+      frame.values[w - 1] = toDouble(words[w].load(memory_order_relaxed));
+
+   atomic_thread_fence(memory_order_acquire); // the copy completes before the sequence is checked again
+   return s[0].load(memory_order_relaxed) == expected;
+}
+
+uint64_t Reader::frames() const
+{
+   return header ? header->frames.load(memory_order_acquire) : 0;
+}
+
+bool Reader::latest(Frame& frame) const
+{
+   for (int attempt = 0; attempt < 16; ++attempt) // the writer may overwrite the slot while it's read, then the next frame is the latest
+   {
+      const uint64_t n = frames();
+      if (n == 0)
+         return false;
+      if (read(n - 1, frame))
+         return true;
+   }
+   return false;
+}
+
+size_t Reader::window(const size_t n, std::vector<Frame>& frames) const
+{
+   frames.clear();
+
+   const uint64_t published = this->frames();
+   const uint64_t first = published > n ? published - n : 0;
+
+   Frame frame;
+   for (uint64_t i = first; i < published; ++i)
+   {
+      if (read(i, frame))
+         frames.push_back(frame);
+   }
+   return frames.size();
+}
+
+#ifdef _WIN32
+
+bool Writer::open(const std::string&, const std::vector<Column>&, const size_t) { return false; }
+void Writer::close() {}
+bool Reader::open(const std::string&) { return false; }
+void Reader::close() {}
+
+#else
+
+bool Writer::open(const std::string& name, const std::vector<Column>& columns, const size_t capacity)
+{
+   close();
+
+   uint32_t frame_words = 1; // t
+   for (auto& column : columns)
+   {
+      if (column.name.size() >= name_size) // a truncated name couldn't be found by readers
+         throw std::runtime_error("SharedTelemetry column name <" + column.name + "> is longer than " + std::to_string(name_size - 1) + " characters.");
+      if (!column.layout.supported)
+         return false;
+      frame_words += static_cast<uint32_t>(column.layout.elements());
+   }
+
+   const uint32_t n_columns = static_cast<uint32_t>(columns.size());
+   const size_t slots = capacity > 0 ? capacity : 1;
+   const size_t size = slotsOffset(n_columns) + slots * slotWords(frame_words) * sizeof(Word);
+
+   shm_unlink(name.c_str()); // replace an object left by a previous run, readers of it keep their mapping
+   const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+   if (fd < 0)
+      return false;
+
+   void* mapping = MAP_FAILED;
+   if (ftruncate(fd, static_cast<off_t>(size)) == 0) // zero filled
+      mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   ::close(fd);
+
+   if (mapping == MAP_FAILED)
+   {
+      shm_unlink(name.c_str());
+      return false;
+   }
+
+   header = static_cast<Header*>(mapping);
+   bytes = size;
+   this->name = name;
+   this->columns = columns;
+   frames = 0;
+
+   header->version = version;
+   header->columns = n_columns;
+   header->frame_words = frame_words;
+   header->capacity = static_cast<uint32_t>(slots);
+   header->frames.store(0, memory_order_relaxed);
+
+   ColumnInfo* info = reinterpret_cast<ColumnInfo*>(header + 1);
+   uint32_t offset = 1;
+   for (uint32_t j = 0; j < n_columns; ++j)
+   {
+      memcpy(info[j].name, columns[j].name.c_str(), columns[j].name.size() + 1);
+      info[j].offset = offset;
+      info[j].elements = static_cast<uint32_t>(columns[j].layout.elements());
+      offset += info[j].elements;
+   }
+
+   atomic_thread_fence(memory_order_release);
+   memcpy(header->magic, magic, sizeof(magic));
+   return true;
+}
+
+void Writer::close()
+{
+   if (header)
+   {
+      munmap(header, bytes);
+      shm_unlink(name.c_str());
+      header = nullptr;
+   }
+}
+
+bool Reader::open(const std::string& name)
+{
+   close();
+
+   const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+   if (fd < 0)
+      return false;
+
+   struct stat st;
+   void* mapping = MAP_FAILED;
+   if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(Header))
+      mapping = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+   ::close(fd);
+
+   if (mapping == MAP_FAILED)
+      return false;
+
+   const Header* h = static_cast<const Header*>(mapping);
+   atomic_thread_fence(memory_order_acquire);
+   const bool valid = memcmp(h->magic, magic, sizeof(magic)) == 0 && h->version == version && h->capacity > 0
+      && slotsOffset(h->columns) + h->capacity * slotWords(h->frame_words) * sizeof(Word) <= static_cast<size_t>(st.st_size);
+
+   if (!valid) // not a SharedTelemetry object, or the writer is still initializing it
+   {
+      munmap(mapping, static_cast<size_t>(st.st_size));
+      return false;
+   }
+
+   header = h;
+   bytes = static_cast<size_t>(st.st_size);
+
+   const ColumnInfo* info = reinterpret_cast<const ColumnInfo*>(h + 1);
+   columns.assign(info, info + h->columns);
+   for (auto& column : columns)
+      column.name[name_size - 1] = '\0';
+   return true;
+}
+
+void Reader::close()
+{
+   if (header)
+   {
+      munmap(const_cast<Header*>(header), bytes);
+      header = nullptr;
+   }
+   columns.clear();
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,251 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "ascent/io/StreamWriter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+using namespace asc;
+using namespace std;
+
+StreamWriter::StreamWriter(const size_t block_size, const size_t n_blocks) : block_size(block_size), full_blocks(n_blocks), free_blocks(n_blocks)
+{
+   for (size_t i = 0; i < n_blocks; ++i)
+   {
+      blocks.emplace_back(new Block());
+      blocks.back()->data.reserve(block_size);
+      free_blocks.push(blocks.back().get());
+   }
+
+   thread = std::thread(&StreamWriter::run, this);
+}
+
+StreamWriter::~StreamWriter()
+{
+   flush();
+
+   stopping = true;
+   wake.notify_one();
+   thread.join();
+}
+
+StreamWriter::Stream* StreamWriter::open(const std::string& filename, const std::string& header, const std::vector<Field>& fields)
+{
+   unique_ptr<Stream> stream(new Stream());
+   stream->filename = filename;
+   stream->fields = fields;
+   stream->file.open(filename);
+
+   if (!stream->file)
+      return nullptr;
+
+   stream->file << header << '\n'; // written before the writer thread ever sees the stream
+
+   streams.push_back(move(stream));
+   return streams.back().get();
+}
+
+void StreamWriter::close(Stream* stream)
+{
+   flush();
+
+   auto it = find_if(streams.begin(), streams.end(), [stream](const unique_ptr<Stream>& p) { return p.get() == stream; });
+   if (it != streams.end())
+   {
+      (*it)->file.close();
+      streams.erase(it);
+   }
+}
+
+void StreamWriter::beginRow(Stream* stream)
+{
+   if (!block)
+   {
+      while (!free_blocks.pop(block)) // all blocks are waiting to be written, so wait for the writer thread to catch up
+      {
+         wake.notify_one();
+         this_thread::yield();
+      }
+   }
+
+   row_begin = block->data.size();
+   in_row = true;
+   row_stream = stream;
+   field = 0;
+   append(&stream, sizeof(Stream*));
+}
+
+void StreamWriter::present(const bool filled)
+{
+   if (row_stream->fields[field++].optional)
+   {
+      const uint8_t flag = filled ? 1 : 0;
+      append(&flag, sizeof(uint8_t));
+   }
+}
+
+void StreamWriter::value(const void* data, const size_t bytes)
+{
+   present(true);
+   append(data, bytes);
+}
+
+void StreamWriter::skip()
+{
+   present(false);
+}
+
+void StreamWriter::value(const std::string& formatted)
+{
+   present(true);
+   const uint32_t n = static_cast<uint32_t>(formatted.size());
+   append(&n, sizeof(uint32_t));
+   append(formatted.data(), n);
+}
+
+void StreamWriter::endRow()
+{
+   in_row = false;
+
+   if (block->data.size() >= block_size)
+      push();
+}
+
+bool StreamWriter::flush()
+{
+   if (!block)
+   {
+      while (!free_blocks.pop(block))
+      {
+         wake.notify_one();
+         this_thread::yield();
+      }
+   }
+
+   if (in_row) // only complete rows are written
+   {
+      block->data.resize(row_begin);
+      in_row = false;
+   }
+
+   block->flush = true;
+   push();
+
+   while (written.load(memory_order_acquire) < pushed)
+   {
+      wake.notify_one();
+      this_thread::yield();
+   }
+
+   return !failed;
+}
+
+void StreamWriter::append(const void* data, const size_t bytes)
+{
+   const char* p = static_cast<const char*>(data);
+   block->data.insert(block->data.end(), p, p + bytes);
+}
+
+void StreamWriter::push()
+{
+   full_blocks.push(block); // can't fail, the queue holds every block
+   block = nullptr;
+   ++pushed;
+   wake.notify_one();
+}
+
+void StreamWriter::run()
+{
+   vector<Stream*> touched; // streams written to since the last flush
+
+   while (true)
+   {
+      Block* full;
+      if (full_blocks.pop(full))
+      {
+         write(*full, touched);
+
+         if (full->flush)
+         {
+            for (Stream* stream : touched)
+            {
+               stream->file.flush();
+               if (!stream->file)
+                  failed = true;
+            }
+            touched.clear();
+         }
+
+         full->data.clear();
+         full->flush = false;
+         free_blocks.push(full);
+         written.fetch_add(1, memory_order_release);
+      }
+      else if (stopping)
+         break;
+      else
+      {
+         unique_lock<mutex> lock(wake_mutex);
+         wake.wait_for(lock, chrono::milliseconds(10), [this] { return !full_blocks.empty() || stopping; });
+      }
+   }
+}
+
+void StreamWriter::write(const Block& block, std::vector<Stream*>& touched)
+{
+   const char* p = block.data.data();
+   const char* end = p + block.data.size();
+
+   string row; // reused for every row in the block
+   while (p < end)
+   {
+      Stream* stream;
+      memcpy(&stream, p, sizeof(Stream*));
+      p += sizeof(Stream*);
+
+      if (find(touched.begin(), touched.end(), stream) == touched.end())
+         touched.push_back(stream);
+
+      row.clear();
+      size_t n = stream->fields.size();
+      for (size_t i = 0; i < n; ++i)
+      {
+         const Field& field = stream->fields[i];
+         const bool filled = !field.optional || *p++ != 0; // an optional field is preceded by whether it has a value in this row, otherwise its cell is left blank
+
+         if (filled && field.layout.supported)
+         {
+            BinaryTrack::print(row, field.layout, p);
+            p += field.layout.bytes();
+         }
+         else if (filled)
+         {
+            uint32_t length;
+            memcpy(&length, p, sizeof(uint32_t));
+            p += sizeof(uint32_t);
+            row.append(p, length);
+            p += length;
+         }
+
+         if (i < n - 1) // not the last field
+            row += ',';
+      }
+
+      row += '\n';
+      stream->file.write(row.data(), row.size());
+   }
+}
\ No newline at end of file
@@ -0,0 +1,358 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "ascent/io/TelemetryServer.h"
+#include "ascent/io/Format.h"
+#include "ascent/io/JsonAPI.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace asc;
+using namespace std;
+
+namespace
+{
+   string frame(const string& text)
+   {
+      const uint32_t length = static_cast<uint32_t>(text.size());
+      string out(sizeof(uint32_t), '\0');
+      memcpy(&out[0], &length, sizeof(uint32_t));
+      return out + text;
+   }
+}
+
+TelemetryServer::~TelemetryServer()
+{
+   stop();
+}
+
+#ifdef _WIN32
+
+bool TelemetryServer::start(const std::string&) { return false; }
+void TelemetryServer::stop() {}
+void TelemetryServer::wake() {}
+void TelemetryServer::run() {}
+
+#else
+
+namespace
+{
+   void setNonBlocking(const int fd)
+   {
+      fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+      fcntl(fd, F_SETFD, FD_CLOEXEC);
+   }
+
+   struct Client
+   {
+      int fd;
+      uint64_t id;
+      string in; // received bytes not yet forming a complete frame
+      string out; // bytes not yet sent
+      bool closed = false;
+   };
+}
+
+bool TelemetryServer::start(const std::string& socket_path)
+{
+   stop();
+
+   sockaddr_un address{};
+   if (socket_path.empty() || socket_path.size() >= sizeof(address.sun_path))
+      return false;
+
+   address.sun_family = AF_UNIX;
+   memcpy(address.sun_path, socket_path.c_str(), socket_path.size());
+
+   listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+   if (listen_fd < 0)
+      return false;
+
+   unlink(socket_path.c_str()); // a stale socket file from a previous run
+   if (bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(listen_fd, 8) < 0 || pipe(wake_fds) < 0)
+   {
+      close(listen_fd);
+      listen_fd = -1;
+      return false;
+   }
+
+   setNonBlocking(listen_fd);
+   setNonBlocking(wake_fds[0]);
+   setNonBlocking(wake_fds[1]);
+
+   path = socket_path;
+   running = true;
+   thread = std::thread(&TelemetryServer::run, this);
+   return true;
+}
+
+void TelemetryServer::stop()
+{
+   if (!running)
+      return;
+
+   running = false;
+   wake();
+   thread.join();
+
+   close(listen_fd);
+   close(wake_fds[0]);
+   close(wake_fds[1]);
+   listen_fd = wake_fds[0] = wake_fds[1] = -1;
+   unlink(path.c_str());
+
+   requests.clear();
+   responses.clear();
+   disconnected.clear();
+   subscriptions.clear();
+   connected = 0;
+}
+
+void TelemetryServer::wake()
+{
+   const char c = 0;
+   ssize_t written = write(wake_fds[1], &c, 1); // if the pipe is full, the server thread is already due to wake
+   (void)written;
+}
+
+void TelemetryServer::run()
+{
+   vector<Client> clients;
+   vector<pollfd> fds;
+   uint64_t next_id = 0;
+
+#ifdef MSG_NOSIGNAL
+   const int send_flags = MSG_NOSIGNAL; // a client disconnecting mustn't raise SIGPIPE in the simulation process
+#else
+   const int send_flags = 0;
+#endif
+
+   while (running)
+   {
+      {
+         lock_guard<std::mutex> lock(mutex);
+         for (Message& response : responses)
+         {
+            auto client = find_if(clients.begin(), clients.end(), [&](const Client& c) { return c.id == response.client; });
+            if (client != clients.end())
+               client->out += response.text;
+         }
+         responses.clear();
+      }
+
+      fds.clear();
+      fds.push_back({ wake_fds[0], POLLIN, 0 });
+      fds.push_back({ listen_fd, POLLIN, 0 });
+      for (Client& client : clients)
+         fds.push_back({ client.fd, static_cast<short>(client.out.empty() ? POLLIN : POLLIN | POLLOUT), 0 });
+
+      if (poll(fds.data(), fds.size(), -1) < 0)
+      {
+         if (errno == EINTR)
+            continue;
+         break;
+      }
+
+      if (fds[0].revents & POLLIN)
+      {
+         char buffer[256];
+         while (read(wake_fds[0], buffer, sizeof(buffer)) > 0) {}
+      }
+
+      if (fds[1].revents & POLLIN)
+      {
+         int fd;
+         while ((fd = accept(listen_fd, nullptr, nullptr)) >= 0)
+         {
+            setNonBlocking(fd);
+#ifdef SO_NOSIGPIPE
+            int on = 1;
+            setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+            Client client;
+            client.fd = fd;
+            client.id = next_id++;
+            clients.push_back(client);
+            fds.push_back({ fd, 0, 0 }); // keeps fds aligned with clients
+            ++connected;
+         }
+      }
+
+      for (size_t k = 0; k < clients.size(); ++k)
+      {
+         Client& client = clients[k];
+         const short revents = fds[k + 2].revents;
+
+         if (revents & (POLLIN | POLLHUP | POLLERR))
+         {
+            char buffer[4096];
+            while (true)
+            {
+               const ssize_t n = recv(client.fd, buffer, sizeof(buffer), 0);
+               if (n > 0)
+                  client.in.append(buffer, static_cast<size_t>(n));
+               else
+               {
+                  if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+                     client.closed = true;
+                  break;
+               }
+            }
+
+            size_t offset = 0;
+            while (client.in.size() - offset >= sizeof(uint32_t))
+            {
+               uint32_t length;
+               memcpy(&length, client.in.data() + offset, sizeof(uint32_t));
+               if (length > max_frame)
+               {
+                  client.closed = true;
+                  break;
+               }
+               if (client.in.size() - offset - sizeof(uint32_t) < length)
+                  break;
+
+               lock_guard<std::mutex> lock(mutex);
+               requests.push_back({ client.id, client.in.substr(offset + sizeof(uint32_t), length) });
+               offset += sizeof(uint32_t) + length;
+            }
+            client.in.erase(0, offset);
+         }
+
+         if (!client.closed && (revents & POLLOUT) && !client.out.empty())
+         {
+            const ssize_t n = send(client.fd, client.out.data(), client.out.size(), send_flags);
+            if (n > 0)
+               client.out.erase(0, static_cast<size_t>(n));
+            else if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+               client.closed = true;
+         }
+
+         if (revents & POLLNVAL)
+            client.closed = true;
+      }
+
+      for (Client& client : clients)
+      {
+         if (client.closed)
+         {
+            close(client.fd);
+            lock_guard<std::mutex> lock(mutex);
+            disconnected.push_back(client.id);
+            --connected;
+         }
+      }
+      clients.erase(remove_if(clients.begin(), clients.end(), [](const Client& c) { return c.closed; }), clients.end());
+   }
+
+   for (Client& client : clients)
+      close(client.fd);
+}
+
+#endif
+
+void TelemetryServer::service(Simulator& simulator)
+{
+   if (connected.load(std::memory_order_relaxed) == 0 && subscriptions.empty())
+      return;
+
+   ++steps;
+
+   deque<Message> pending;
+   vector<uint64_t> gone;
+   {
+      lock_guard<std::mutex> lock(mutex);
+      pending.swap(requests);
+      gone.swap(disconnected);
+   }
+
+   if (!gone.empty())
+      subscriptions.erase(remove_if(subscriptions.begin(), subscriptions.end(), [&](const Subscription& s) { return find(gone.begin(), gone.end(), s.client) != gone.end(); }), subscriptions.end());
+
+   deque<Message> out;
+   for (Message& request : pending)
+      out.push_back({ request.client, frame(handle(simulator, request.client, request.text)) });
+
+   for (Subscription& subscription : subscriptions)
+   {
+      if (steps % subscription.every == 0)
+      {
+         string update = "{\"t\":";
+         Format::appendJson(update, simulator.t);
+         update += ",\"output\":" + handle(simulator, subscription.client, subscription.input) + "}";
+         out.push_back({ subscription.client, frame(update) });
+      }
+   }
+
+   if (!out.empty())
+   {
+      {
+         lock_guard<std::mutex> lock(mutex);
+         for (Message& message : out)
+            responses.push_back(std::move(message));
+      }
+      wake();
+   }
+}
+
+std::string TelemetryServer::handle(Simulator& simulator, const uint64_t client, const std::string& request)
+{
+   // Errors set by a bad request (e.g. a misspelled variable) belong to the client, not the simulation.
+   const bool error = simulator.error;
+   const size_t n_errors = simulator.error_descriptions.size();
+
+   jsoncons::json output;
+   try
+   {
+      jsoncons::json input = jsoncons::json::parse(request);
+
+      if (input.is_object() && input.count("subscribe"))
+      {
+         Subscription subscription;
+         subscription.client = client;
+         subscription.input = input["subscribe"].to_string();
+         subscription.every = input.count("every") ? max<size_t>(input["every"].as<size_t>(), 1) : 1;
+         subscriptions.push_back(subscription);
+         output["subscribed"] = true;
+      }
+      else if (input.is_object() && input.count("unsubscribe"))
+      {
+         subscriptions.erase(remove_if(subscriptions.begin(), subscriptions.end(), [&](const Subscription& s) { return s.client == client; }), subscriptions.end());
+         output["subscribed"] = false;
+      }
+      else
+         output = JsonAPI::io(input);
+   }
+   catch (const std::exception& e)
+   {
+      simulator.error = error;
+      simulator.error_descriptions.resize(n_errors);
+      output = jsoncons::json();
+      output["error"] = string(e.what());
+   }
+
+   return output.to_string();
+}
\ No newline at end of file
@@ -0,0 +1,176 @@
+// Copyright (c) 2015 - 2016 Anyar, Inc.
+// 
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Runs a SharedTelemetry writer and reader in separate processes and checks that the reader only ever sees complete, consistent frames.
+// The writer publishes frames into a small ring as fast as it can, so the reader regularly races it and reads slots that are being overwritten.
+// Every value of frame i is derived from i, so a torn frame (values from different writes) is detected. Exits with 0 on success.
+
+#include "ascent/io/SharedTelemetry.h"
+
+#include <Eigen/Dense>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace asc;
+
+namespace
+{
+   const uint64_t n_frames = 200000;
+   const size_t capacity = 4;
+
+   typedef Eigen::Matrix<double, 8, 8> Matrix; // a wide frame, so that copying it often overlaps the writer
+
+   double time(const uint64_t i) { return 0.01 * static_cast<double>(i); }
+
+   bool consistent(const SharedTelemetry::Frame& frame)
+   {
+      const double i = static_cast<double>(frame.index);
+      if (frame.t != time(frame.index) || frame.values.size() != 2 + Matrix::SizeAtCompileTime)
+         return false;
+      if (frame.values[0] != i || frame.values.back() != static_cast<double>(frame.index % 7))
+         return false;
+      for (size_t k = 0; k < Matrix::SizeAtCompileTime; ++k)
+      {
+         if (frame.values[1 + k] != i * static_cast<double>(k + 1))
+            return false;
+      }
+      return true;
+   }
+
+   int writer(const std::string& name, const int ready, const int go)
+   {
+      std::vector<SharedTelemetry::Writer::Column> columns(3);
+      columns[0].name = "m x";
+      columns[0].layout = BinaryTrack::Type<double>::layout();
+      columns[1].name = "m A";
+      columns[1].layout = BinaryTrack::Type<Matrix>::layout();
+      columns[2].name = "m n";
+      columns[2].layout = BinaryTrack::Type<int>::layout();
+
+      SharedTelemetry::Writer writer;
+      const bool opened = writer.open(name, columns, capacity);
+
+      char c = opened ? 1 : 0;
+      if (write(ready, &c, 1) != 1 || !opened)
+         return 1;
+      if (read(go, &c, 1) != 1) // the reader has opened the object
+         return 1;
+
+      double x;
+      Matrix A;
+      int n;
+      const std::vector<const void*> values = { &x, &A, &n };
+      for (uint64_t i = 0; i < n_frames; ++i)
+      {
+         const double d = static_cast<double>(i);
+         x = d;
+         for (Eigen::Index k = 0; k < A.size(); ++k)
+            A(k) = d * static_cast<double>(k + 1);
+         n = static_cast<int>(i % 7);
+         writer.write(time(i), values);
+      }
+
+      if (read(go, &c, 1) != 1) // keep the object until the reader is done
+         return 1;
+      return 0;
+   }
+
+   int reader(const std::string& name, const pid_t child, const int ready, const int go)
+   {
+      int failures = 0;
+      auto check = [&](const bool condition, const char* description)
+      {
+         if (!condition)
+         {
+            std::printf("FAILED: %s\n", description);
+            ++failures;
+         }
+      };
+
+      char c = 0;
+      if (read(ready, &c, 1) != 1 || c != 1)
+      {
+         std::printf("FAILED: the writer couldn't create %s\n", name.c_str());
+         return 1;
+      }
+
+      SharedTelemetry::Reader reader;
+      check(reader.open(name), "Reader::open");
+      check(reader.find("m A") && reader.find("m A")->elements == Matrix::SizeAtCompileTime, "Reader::find");
+      if (write(go, &c, 1) != 1)
+         return 1;
+
+      SharedTelemetry::Frame frame;
+      std::vector<SharedTelemetry::Frame> frames;
+      uint64_t last = 0;
+      size_t latest_reads = 0, window_reads = 0;
+      while (reader.frames() < n_frames)
+      {
+         if (reader.latest(frame))
+         {
+            ++latest_reads;
+            check(consistent(frame), "latest() returned a torn frame");
+            check(frame.index >= last, "latest() went backwards");
+            last = frame.index;
+         }
+
+         reader.window(capacity, frames);
+         for (size_t k = 0; k < frames.size(); ++k)
+         {
+            ++window_reads;
+            check(consistent(frames[k]), "window() returned a torn frame");
+            check(k == 0 || frames[k].index > frames[k - 1].index, "window() isn't oldest first");
+         }
+
+         if (failures > 10)
+            break;
+      }
+
+      check(reader.latest(frame) && frame.index == n_frames - 1 && consistent(frame), "the last frame");
+      check(reader.window(capacity, frames) == capacity && frames.front().index == n_frames - capacity, "the final window");
+      check(!reader.read(0, frame), "an overwritten frame was read");
+
+      if (write(go, &c, 1) != 1)
+         return 1;
+
+      int status = 0;
+      waitpid(child, &status, 0);
+      check(WIFEXITED(status) && WEXITSTATUS(status) == 0, "the writer process");
+
+      std::printf("%zu latest and %zu window reads of %llu frames, %d failures\n", latest_reads, window_reads, static_cast<unsigned long long>(n_frames), failures);
+      return failures == 0 ? 0 : 1;
+   }
+}
+
+int main()
+{
+   const std::string name = "/ascent_shared_telemetry_test_" + std::to_string(getpid());
+
+   int ready[2], go[2]; // writer -> reader, reader -> writer
+   if (pipe(ready) != 0 || pipe(go) != 0)
+      return 1;
+
+   const pid_t child = fork();
+   if (child < 0)
+      return 1;
+   if (child == 0)
+      return writer(name, ready[1], go[0]);
+
+   return reader(name, child, ready[0], go[1]);
+}
\ No newline at end of file